@@ -0,0 +1,557 @@
+/*
+   Checks single-precision rangefinder reads against double precision, and
+   each accelerator's reads, clearances, and collisions against those found
+   without one
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/parsers/webots/world.hpp>
+#include <simsensors/src/parsers/webots/robot.hpp>
+#include <simsensors/src/world.hpp>
+
+#include "../benchmark/generator.hpp"
+
+// Distances are truncated to whole millimeters, so a float error of a few
+// micrometers can still move a reading across a millimeter boundary
+static constexpr int TOLERANCE_MM = 1;
+
+// Beams that graze a wall's end can hit it in one precision and miss it in
+// the other; allow this small a fraction of them
+static constexpr double MAX_GRAZING_FRACTION = 1e-4;
+
+static constexpr int POSES = 100;
+
+static constexpr int CLEARANCE_QUERIES = 20000;
+
+// Clearances may differ by rounding
+static constexpr double CLEARANCE_TOLERANCE_M = 1e-9;
+
+// Farthest a swept collision query moves along each axis
+static constexpr double SWEEP_M = 0.5;
+
+// Random inserts, moves, and removals applied to the worlds of an edit
+// check, which compares them after every EDITS_PER_CHECK
+static constexpr int EDITS = 400;
+static constexpr int EDITS_PER_CHECK = 50;
+static constexpr int EDIT_WALLS = 2000;
+
+// Points tested along each sweep that climbs or descends past obstacles
+static constexpr int SWEEP_SAMPLES = 64;
+
+static const char * LAYOUT_NAMES[] = {"random", "maze"};
+static const char * ACCELERATOR_NAMES[] = {"none", "grid", "bvh", "field"};
+
+static bool parse_generated(const string & text, simsens::World * world,
+        simsens::Robot * robot=nullptr)
+{
+    char file_name[] = "/tmp/simsens-accuracy-XXXXXX";
+    const auto fd = mkstemp(file_name);
+
+    if (fd < 0 || !Generator::save(file_name, text)) {
+        return false;
+    }
+
+    close(fd);
+
+    if (world) {
+        simsens::WorldParser::parse(file_name, *world);
+    }
+    else {
+        simsens::RobotParser::parse(file_name, *robot);
+    }
+
+    remove(file_name);
+
+    return true;
+}
+
+// Returns true if the float reads are within tolerance
+static bool check(const Generator::layout_t layout, const size_t nwalls,
+        const simsens::accelerator_t accelerator,
+        simsens::Rangefinder & rangefinder, const size_t frame_size)
+{
+    simsens::World world;
+
+    if (!parse_generated(Generator::world(layout, nwalls, 1), &world,
+                nullptr)) {
+        return false;
+    }
+
+    world.use_accelerator(accelerator);
+
+    mt19937 rng(1);
+    const auto size_m = Generator::world_size_m(layout, nwalls);
+    uniform_real_distribution<double> position(-size_m / 2, size_m / 2);
+    uniform_real_distribution<double> angle(-M_PI, M_PI);
+    uniform_real_distribution<double> pitch(-0.3, 0.3);
+
+    vector<int> expected(frame_size);
+    vector<int> actual(frame_size);
+
+    size_t beams = 0;
+    size_t grazing = 0;
+    int max_error_mm = 0;
+
+    for (int p=0; p<POSES; ++p) {
+
+        simsens::pose_t pose = {};
+        pose.x = position(rng);
+        pose.y = position(rng);
+        pose.z = 0.5;
+        pose.theta = pitch(rng);
+        pose.psi = angle(rng);
+
+        rangefinder.read<double>(pose, world, expected.data());
+        rangefinder.read<float>(pose, world, actual.data());
+
+        for (size_t k=0; k<frame_size; ++k) {
+
+            beams++;
+
+            const auto error = abs(actual[k] - expected[k]);
+
+            if (error > TOLERANCE_MM || (actual[k] < 0) != (expected[k] < 0)) {
+                grazing++;
+            }
+            else {
+                max_error_mm = max(max_error_mm, error);
+            }
+        }
+    }
+
+    const auto ok = grazing <= MAX_GRAZING_FRACTION * beams;
+
+    printf("%-6s %6zu walls %-5s: %8zu beams, max error %d mm, "
+            "%zu beyond %d mm  %s\n",
+            LAYOUT_NAMES[layout], nwalls, ACCELERATOR_NAMES[accelerator],
+            beams, max_error_mm, grazing, TOLERANCE_MM, ok ? "ok" : "FAILED");
+
+    return ok;
+}
+
+// Returns true if every accelerator's reads are within tolerance of those
+// without one, in a world of walls of many heights, boxes, cylinders, and
+// a floor, and their collisions are the same.  The grid's and BVH's
+// clearances must be the same too; the distance field's may fall short,
+// but never exceed them.
+static bool check_accelerators(const Generator::layout_t layout,
+        const size_t nwalls, simsens::Rangefinder & rangefinder,
+        const size_t frame_size)
+{
+    const auto text = Generator::world(layout, nwalls, 1, true);
+
+    simsens::World exact;
+
+    if (!parse_generated(text, &exact)) {
+        return false;
+    }
+
+    mt19937 rng(1);
+    const auto size_m = Generator::world_size_m(layout, nwalls);
+    uniform_real_distribution<double> position(-size_m / 2, size_m / 2);
+    uniform_real_distribution<double> angle(-M_PI, M_PI);
+    uniform_real_distribution<double> pitch(-0.3, 0.3);
+    uniform_real_distribution<double> altitude(0, 3.5);
+    uniform_real_distribution<double> step(-SWEEP_M, SWEEP_M);
+
+    vector<simsens::pose_t> poses(POSES);
+    vector<int> expected(POSES * frame_size);
+
+    for (int p=0; p<POSES; ++p) {
+
+        auto & pose = poses[p];
+        pose.x = position(rng);
+        pose.y = position(rng);
+        pose.z = altitude(rng);
+        pose.theta = pitch(rng);
+        pose.psi = angle(rng);
+
+        rangefinder.read(pose, exact, &expected[p * frame_size]);
+    }
+
+    vector<simsens::vec3_t> froms(CLEARANCE_QUERIES);
+    vector<simsens::vec3_t> tos(CLEARANCE_QUERIES);
+    vector<double> clearances(CLEARANCE_QUERIES);
+    vector<bool> collisions(CLEARANCE_QUERIES);
+    vector<bool> swept_collisions(CLEARANCE_QUERIES);
+
+    for (int q=0; q<CLEARANCE_QUERIES; ++q) {
+
+        froms[q] = {position(rng), position(rng), altitude(rng)};
+        tos[q] = {froms[q].x + step(rng), froms[q].y + step(rng),
+            froms[q].z + step(rng)};
+
+        clearances[q] = exact.clearance(froms[q]).clearance_m;
+        collisions[q] = exact.collided(froms[q]);
+        swept_collisions[q] = exact.collided(froms[q], tos[q]);
+    }
+
+    vector<int> actual(frame_size);
+
+    bool ok = true;
+
+    for (auto accelerator : {simsens::ACCELERATOR_GRID,
+            simsens::ACCELERATOR_BVH, simsens::ACCELERATOR_DISTANCE_FIELD}) {
+
+        simsens::World world;
+
+        if (!parse_generated(text, &world)) {
+            return false;
+        }
+
+        world.use_accelerator(accelerator);
+
+        const auto field = accelerator == simsens::ACCELERATOR_DISTANCE_FIELD;
+
+        size_t beams = 0;
+        size_t grazing = 0;
+
+        for (int p=0; p<POSES; ++p) {
+
+            rangefinder.read(poses[p], world, actual.data());
+
+            for (size_t k=0; k<frame_size; ++k) {
+                const auto want = expected[p * frame_size + k];
+                beams++;
+                grazing += abs(actual[k] - want) > TOLERANCE_MM ||
+                    (actual[k] < 0) != (want < 0);
+            }
+        }
+
+        size_t wrong = 0;
+        size_t mismatched = 0;
+        size_t collided = 0;
+        double max_understated_m = 0;
+
+        for (int q=0; q<CLEARANCE_QUERIES; ++q) {
+
+            const auto want = clearances[q];
+            const auto got = world.clearance(froms[q]).clearance_m;
+
+            wrong += got > want + CLEARANCE_TOLERANCE_M ||
+                (!field && got < want - CLEARANCE_TOLERANCE_M);
+
+            if (got < want) {
+                max_understated_m = max(max_understated_m, want - got);
+            }
+
+            collided += collisions[q] + swept_collisions[q];
+
+            mismatched += world.collided(froms[q]) != collisions[q];
+            mismatched += world.collided(froms[q], tos[q]) !=
+                swept_collisions[q];
+        }
+
+        const auto accelerator_ok = grazing <= MAX_GRAZING_FRACTION * beams &&
+            wrong == 0 && mismatched == 0;
+
+        printf("%-6s %6zu mixed %-5s: %8zu beams, %zu beyond %d mm; "
+                "%d clearances, %zu wrong, at most %.3f m under; "
+                "%zu collisions, %zu mismatched  %s\n",
+                LAYOUT_NAMES[layout], nwalls, ACCELERATOR_NAMES[accelerator],
+                beams, grazing, TOLERANCE_MM, CLEARANCE_QUERIES, wrong,
+                max_understated_m, collided, mismatched,
+                accelerator_ok ? "ok" : "FAILED");
+
+        ok = accelerator_ok && ok;
+    }
+
+    return ok;
+}
+
+// Returns true if, as obstacles are inserted, moved, and removed, every
+// accelerator's reads, collisions, and clearances stay as they are without
+// one, the distance field's clearances never exceeding them.  Some inserts
+// land outside the world, so that the grid has to be rebuilt, and removed
+// obstacles' slots are reused.
+static bool check_edits(const Generator::layout_t layout,
+        simsens::Rangefinder & rangefinder, const size_t frame_size)
+{
+    const auto text = Generator::world(layout, EDIT_WALLS, 1, true);
+
+    const simsens::accelerator_t accelerators[] = {
+        simsens::ACCELERATOR_NONE, simsens::ACCELERATOR_GRID,
+        simsens::ACCELERATOR_BVH, simsens::ACCELERATOR_DISTANCE_FIELD};
+
+    vector<simsens::World> worlds(4);
+
+    for (size_t w=0; w<worlds.size(); ++w) {
+
+        if (!parse_generated(text, &worlds[w])) {
+            return false;
+        }
+
+        worlds[w].use_accelerator(accelerators[w]);
+    }
+
+    // Every world numbers its obstacles alike, so one handle serves all
+    vector<simsens::obstacle_t> live;
+
+    for (auto prefix : {"wall", "box", "cylinder"}) {
+        for (int k=0; ; ++k) {
+
+            char name[100] = {};
+            snprintf(name, sizeof(name), "%s%d", prefix, k);
+
+            simsens::obstacle_t obstacle = {};
+
+            if (!worlds[0].find_obstacle(name, obstacle)) {
+                break;
+            }
+
+            live.push_back(obstacle);
+        }
+    }
+
+    mt19937 rng(1);
+    const auto size_m = Generator::world_size_m(layout, EDIT_WALLS);
+    uniform_real_distribution<double> position(-size_m / 2, size_m / 2);
+    uniform_real_distribution<double> angle(-M_PI, M_PI);
+    uniform_real_distribution<double> pitch(-0.3, 0.3);
+    uniform_real_distribution<double> altitude(0, 3.5);
+    uniform_real_distribution<double> step(-SWEEP_M, SWEEP_M);
+
+    vector<int> expected(frame_size);
+    vector<int> actual(frame_size);
+
+    size_t beams = 0;
+    size_t differing = 0;
+    size_t wrong = 0;
+    size_t mismatched = 0;
+    size_t outside_count = 0;
+
+    for (int edit=1; edit<=EDITS; ++edit) {
+
+        // Half of the edits insert, mostly walls, so that some walls are
+        // added beyond the removed ones whose slots are reused
+        const auto choice = rng() % 8;
+
+        const simsens::vec3_t where = {
+            position(rng), position(rng), altitude(rng) / 2};
+        const simsens::rotation_t rotation = {0, 0, 1, angle(rng)};
+
+        if (choice < 4 || live.empty()) {
+
+            // One insert in eight lands beyond the edge of the world
+            const auto outside = rng() % 8 == 0;
+            const simsens::vec3_t at = {
+                outside ? size_m : where.x, where.y, where.z};
+
+            const auto type = rng() % 4;
+
+            simsens::obstacle_t inserted[4] = {};
+
+            for (size_t w=0; w<worlds.size(); ++w) {
+                inserted[w] = type < 2 ?
+                    worlds[w].insert_wall(at, rotation, {0.1, 1, 1 + at.z}) :
+                    type == 2 ?
+                    worlds[w].insert_box(at, rotation, {0.5, 0.5, 0.5}) :
+                    worlds[w].insert_cylinder(at, 0.3, 0.5);
+            }
+
+            for (size_t w=1; w<worlds.size(); ++w) {
+                mismatched += inserted[w].type != inserted[0].type ||
+                    inserted[w].index != inserted[0].index;
+            }
+
+            live.push_back(inserted[0]);
+            outside_count += outside;
+        }
+
+        else {
+
+            const auto m = rng() % live.size();
+
+            for (auto & world : worlds) {
+                mismatched += choice < 7 ?
+                    !world.move_obstacle(live[m], where, rotation) :
+                    !world.remove_obstacle(live[m]);
+            }
+
+            if (choice == 7) {
+                live[m] = live.back();
+                live.pop_back();
+            }
+        }
+
+        if (edit % EDITS_PER_CHECK) {
+            continue;
+        }
+
+        for (int p=0; p<POSES/10; ++p) {
+
+            simsens::pose_t pose = {};
+            pose.x = position(rng);
+            pose.y = position(rng);
+            pose.z = altitude(rng);
+            pose.theta = pitch(rng);
+            pose.psi = angle(rng);
+
+            rangefinder.read(pose, worlds[0], expected.data());
+
+            for (size_t w=1; w<worlds.size(); ++w) {
+
+                rangefinder.read(pose, worlds[w], actual.data());
+
+                for (size_t k=0; k<frame_size; ++k) {
+                    beams++;
+                    differing += actual[k] != expected[k];
+                }
+            }
+        }
+
+        for (int q=0; q<CLEARANCE_QUERIES/20; ++q) {
+
+            const simsens::vec3_t from = {
+                position(rng), position(rng), altitude(rng)};
+            const simsens::vec3_t to = {
+                from.x + step(rng), from.y + step(rng), from.z + step(rng)};
+
+            const auto want = worlds[0].clearance(from).clearance_m;
+            const auto collided = worlds[0].collided(from);
+            const auto swept = worlds[0].collided(from, to);
+
+            for (size_t w=1; w<worlds.size(); ++w) {
+
+                const auto field = accelerators[w] ==
+                    simsens::ACCELERATOR_DISTANCE_FIELD;
+
+                const auto got = worlds[w].clearance(from).clearance_m;
+
+                wrong += got > want + CLEARANCE_TOLERANCE_M ||
+                    (!field && got < want - CLEARANCE_TOLERANCE_M);
+
+                mismatched += worlds[w].collided(from) != collided;
+                mismatched += worlds[w].collided(from, to) != swept;
+            }
+        }
+    }
+
+    const auto ok = differing == 0 && wrong == 0 && mismatched == 0;
+
+    printf("%-6s %6d mixed edits: %d edits, %zu outside; %zu beams, "
+            "%zu differing; %zu clearances wrong; %zu mismatched  %s\n",
+            LAYOUT_NAMES[layout], EDIT_WALLS, EDITS, outside_count, beams,
+            differing, wrong, mismatched, ok ? "ok" : "FAILED");
+
+    return ok;
+}
+
+// Returns true if a sweep collides wherever a point along it does, for
+// sweeps that climb and descend past raised boxes and cylinders
+static bool check_sweeps()
+{
+    simsens::World world;
+
+    const simsens::rotation_t upright = {0, 0, 1, 0};
+
+    for (int k=0; k<4; ++k) {
+        world.insert_box({2. * k, 0, 1.5}, upright, {1, 1, 1});
+        world.insert_cylinder({2. * k, 2, 1.5}, 0.5, 1);
+        world.insert_wall({2. * k, 4, 0.5}, upright, {1, 0.1, 1});
+    }
+
+    // Straight up into the underside of the first box
+    auto ok = world.collided({0, 0, 0.5}, {0, 0, 1.5}) &&
+        !world.collided({0, 0, 0.2}, {0, 0, 0.8});
+
+    mt19937 rng(1);
+    uniform_real_distribution<double> position(-1, 8);
+    uniform_real_distribution<double> altitude(0, 2.5);
+    uniform_real_distribution<double> step(-1, 1);
+
+    size_t missed = 0;
+    size_t collided = 0;
+
+    for (int q=0; q<CLEARANCE_QUERIES; ++q) {
+
+        const simsens::vec3_t from = {
+            position(rng), position(rng), altitude(rng)};
+        const simsens::vec3_t to = {
+            from.x + step(rng), from.y + step(rng), from.z + step(rng)};
+
+        auto touched = false;
+
+        for (int s=0; s<=SWEEP_SAMPLES && !touched; ++s) {
+            const auto t = (double)s / SWEEP_SAMPLES;
+            touched = world.collided({from.x + t * (to.x - from.x),
+                    from.y + t * (to.y - from.y),
+                    from.z + t * (to.z - from.z)});
+        }
+
+        const auto swept = world.collided(from, to);
+
+        collided += swept;
+        missed += touched && !swept;
+    }
+
+    ok = ok && missed == 0;
+
+    printf("climbing sweeps: %d sweeps, %zu collisions, %zu missed  %s\n",
+            CLEARANCE_QUERIES, collided, missed, ok ? "ok" : "FAILED");
+
+    return ok;
+}
+
+int main()
+{
+    simsens::Robot robot;
+
+    if (!parse_generated(Generator::robot(64, 48), nullptr, &robot)) {
+        return 1;
+    }
+
+    auto rangefinder = robot.rangefinders.begin()->second;
+
+    bool ok = true;
+
+    for (auto layout : {Generator::LAYOUT_RANDOM, Generator::LAYOUT_MAZE}) {
+        for (auto nwalls : {100, 5000}) {
+            for (auto accelerator : {simsens::ACCELERATOR_NONE,
+                    simsens::ACCELERATOR_GRID, simsens::ACCELERATOR_BVH,
+                    simsens::ACCELERATOR_DISTANCE_FIELD}) {
+                ok = check(layout, nwalls, accelerator, *rangefinder,
+                        64 * 48) && ok;
+            }
+        }
+    }
+
+    for (auto layout : {Generator::LAYOUT_RANDOM, Generator::LAYOUT_MAZE}) {
+        for (auto nwalls : {100, 5000}) {
+            ok = check_accelerators(layout, nwalls, *rangefinder, 64 * 48) &&
+                ok;
+        }
+    }
+
+    for (auto layout : {Generator::LAYOUT_RANDOM, Generator::LAYOUT_MAZE}) {
+        ok = check_edits(layout, *rangefinder, 64 * 48) && ok;
+    }
+
+    ok = check_sweeps() && ok;
+
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,260 @@
+/*
+   Synthetic Webots worlds and robots for benchmarking
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+class Generator {
+
+    public:
+
+        typedef enum {
+            LAYOUT_RANDOM,
+            LAYOUT_MAZE
+        } layout_t;
+
+        // Walls are spread so that their density stays the same at any
+        // count; this is the side of the square they occupy
+        static double world_size_m(const layout_t layout, const size_t nwalls)
+        {
+            return layout == LAYOUT_MAZE ? maze_cells(nwalls) :
+                max(2., 2 * sqrt((double)nwalls));
+        }
+
+        // Randomly placed and oriented walls, or the walls of a grid maze
+        // with one-meter cells, in Webots world-file syntax.  A mixed world
+        // has walls of many heights, and a floor and one box and one
+        // cylinder per MIXED_WALLS_PER_PRIMITIVE walls, some standing on
+        // the floor and some floating above it.
+        static string world(const layout_t layout, const size_t nwalls,
+                const unsigned seed, const bool mixed=false)
+        {
+            mt19937 rng(seed);
+
+            string text = "#VRML_SIM R2023b utf8\n\n";
+
+            if (layout == LAYOUT_RANDOM) {
+                random_walls(text, nwalls, rng, mixed);
+            }
+            else {
+                maze_walls(text, nwalls, rng, mixed);
+            }
+
+            if (mixed) {
+                text += "Floor {\n}\n";
+                primitives(text, world_size_m(layout, nwalls),
+                        nwalls / MIXED_WALLS_PER_PRIMITIVE + 1, rng);
+            }
+
+            return text;
+        }
+
+        // A robot with one rangefinder of the given size, in Webots
+        // proto-file syntax
+        static string robot(const int width, const int height)
+        {
+            char text[1000] = {};
+
+            snprintf(text, sizeof(text),
+                    "PROTO Bench [\n]\n{\n  Robot {\n    children [\n"
+                    "    RangeFinder {\n"
+                    "      fieldOfView 1.5\n"
+                    "      width %d\n"
+                    "      height %d\n"
+                    "      minRange 0.01\n"
+                    "      maxRange 20.0\n"
+                    "      translation 0 0 0\n"
+                    "      rotation 0 0 1 0\n"
+                    "      name \"bench\"\n"
+                    "    }\n    ]\n  }\n}\n",
+                    width, height);
+
+            return text;
+        }
+
+        static bool save(const string & file_name, const string & text)
+        {
+            auto fp = fopen(file_name.c_str(), "w");
+
+            if (!fp) {
+                fprintf(stderr, "Unable to open file %s for output\n",
+                        file_name.c_str());
+                return false;
+            }
+
+            fwrite(text.data(), 1, text.size(), fp);
+            fclose(fp);
+
+            return true;
+        }
+
+    private:
+
+        static constexpr size_t MIXED_WALLS_PER_PRIMITIVE = 20;
+
+        // Height of the next wall: always a meter, or anywhere from half a
+        // meter to three in a mixed world
+        static double wall_height(mt19937 & rng, const bool mixed)
+        {
+            return mixed ? uniform_real_distribution<double>(0.5, 3)(rng) : 1;
+        }
+
+        static void add_wall(string & text, const size_t index,
+                const double x, const double y, const double angle,
+                const double thickness, const double length,
+                const double height)
+        {
+            char wall[300] = {};
+
+            snprintf(wall, sizeof(wall),
+                    "DEF wall Wall {\n"
+                    "  translation %f %f 0\n"
+                    "  rotation 0 0 1 %f\n"
+                    "  name \"wall%zu\"\n"
+                    "  size %f %f %f\n"
+                    "}\n",
+                    x, y, angle, index, thickness, length, height);
+
+            text += wall;
+        }
+
+        static void random_walls(string & text, const size_t nwalls,
+                mt19937 & rng, const bool mixed)
+        {
+            const auto half = world_size_m(LAYOUT_RANDOM, nwalls) / 2;
+
+            uniform_real_distribution<double> position(-half, half);
+            uniform_real_distribution<double> angle(-M_PI, M_PI);
+            uniform_real_distribution<double> thickness(0.01, 0.2);
+            uniform_real_distribution<double> length(0.2, 3);
+
+            for (size_t k=0; k<nwalls; ++k) {
+                add_wall(text, k, position(rng), position(rng), angle(rng),
+                        thickness(rng), length(rng), wall_height(rng, mixed));
+            }
+        }
+
+        // Enough cells for the maze to have at least nwalls edges
+        static int maze_cells(const size_t nwalls)
+        {
+            return max(1, (int)ceil(sqrt(nwalls / 2.)));
+        }
+
+        // Picks nwalls of the edges of a square grid of one-meter cells
+        static void maze_walls(string & text, const size_t nwalls,
+                mt19937 & rng, const bool mixed)
+        {
+            const auto cells = maze_cells(nwalls);
+            const auto half = cells / 2.;
+
+            // Edge e < cells*(cells+1) runs along x; the rest along y
+            vector<size_t> edges(2 * cells * (cells + 1));
+
+            for (size_t e=0; e<edges.size(); ++e) {
+                edges[e] = e;
+            }
+
+            shuffle(edges.begin(), edges.end(), rng);
+
+            const auto count = min(nwalls, edges.size());
+
+            for (size_t k=0; k<count; ++k) {
+
+                const auto along_x = edges[k] < edges.size() / 2;
+                const auto e = along_x ? edges[k] : edges[k] - edges.size() / 2;
+                const auto row = e / cells;
+                const auto col = e % cells;
+                const auto height = wall_height(rng, mixed);
+
+                // A wall's length runs along its local y axis
+                if (along_x) {
+                    add_wall(text, k, col + 0.5 - half, row - half, M_PI / 2,
+                            0.05, 1, height);
+                }
+                else {
+                    add_wall(text, k, row - half, col + 0.5 - half, 0,
+                            0.05, 1, height);
+                }
+            }
+        }
+
+        // Boxes and cylinders scattered over the square the walls occupy,
+        // half of them lifted off the floor
+        static void primitives(string & text, const double size_m,
+                const size_t count, mt19937 & rng)
+        {
+            uniform_real_distribution<double> position(-size_m / 2, size_m / 2);
+            uniform_real_distribution<double> angle(-M_PI, M_PI);
+            uniform_real_distribution<double> side(0.2, 1.5);
+            uniform_real_distribution<double> radius(0.1, 0.6);
+            uniform_real_distribution<double> height(0.3, 2.5);
+            uniform_real_distribution<double> lift(0, 1);
+
+            char shape[300] = {};
+
+            for (size_t k=0; k<count; ++k) {
+
+                const auto x = position(rng);
+                const auto y = position(rng);
+                const auto a = angle(rng);
+                const auto sx = side(rng);
+                const auto sy = side(rng);
+                const auto h = height(rng);
+                const auto z = h / 2 + (k % 2 ? lift(rng) : 0);
+
+                snprintf(shape, sizeof(shape),
+                        "DEF box SolidBox {\n"
+                        "  translation %f %f %f\n"
+                        "  rotation 0 0 1 %f\n"
+                        "  size %f %f %f\n"
+                        "  name \"box%zu\"\n"
+                        "}\n",
+                        x, y, z, a, sx, sy, h, k);
+
+                text += shape;
+            }
+
+            for (size_t k=0; k<count; ++k) {
+
+                const auto x = position(rng);
+                const auto y = position(rng);
+                const auto r = radius(rng);
+                const auto h = height(rng);
+                const auto z = h / 2 + (k % 2 ? lift(rng) : 0);
+
+                snprintf(shape, sizeof(shape),
+                        "DEF cylinder PillarCylinder {\n"
+                        "  translation %f %f %f\n"
+                        "  radius %f\n"
+                        "  height %f\n"
+                        "  name \"cylinder%zu\"\n"
+                        "}\n",
+                        x, y, z, r, h, k);
+
+                text += shape;
+            }
+        }
+};
@@ -0,0 +1,463 @@
+/*
+   Throughput benchmarks for sensor reads, collision queries, and parsing
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/parsers/webots/world.hpp>
+#include <simsensors/src/parsers/webots/robot.hpp>
+#include <simsensors/src/profiler.hpp>
+#include <simsensors/src/threadpool.hpp>
+#include <simsensors/src/world.hpp>
+
+#include "generator.hpp"
+
+typedef struct {
+    string benchmark;
+    string layout;
+    size_t walls;
+    size_t beams;
+    string accelerator;
+    string precision;
+    string unit;
+    double work_per_op;  // beams, queries, or megabytes per operation
+    vector<double> seconds_per_op;
+} result_t;
+
+typedef struct {
+    vector<Generator::layout_t> layouts;
+    vector<size_t> walls;
+    vector<size_t> beams;
+    simsens::accelerator_t accelerator;
+    bool single_precision;
+    double noise_sigma_m;
+    double min_time_s;
+    unsigned seed;
+    const char * json_file_name;
+    const char * trace_file_name;
+    FILE * table;
+} options_t;
+
+static const char * LAYOUT_NAMES[] = {"random", "maze"};
+static const char * ACCELERATOR_NAMES[] = {"none", "grid", "bvh", "field"};
+
+// Smallest sample, so that timer resolution doesn't matter
+static constexpr double MIN_SAMPLE_S = 1e-3;
+static constexpr size_t MIN_SAMPLES = 10;
+static constexpr size_t MAX_SAMPLES = 1000;
+
+static double now_s()
+{
+    return chrono::duration<double>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Calls op(k) for k = 0, 1, ... in timed batches, sized so that each takes
+// at least MIN_SAMPLE_S, and returns the seconds per call in each batch
+template <typename F>
+static vector<double> measure(const double min_time_s, F op)
+{
+    size_t batch = 1;
+    size_t k = 0;
+
+    // Warm up, and grow the batch until it is long enough to time
+    while (true) {
+        const auto start = now_s();
+        for (size_t j=0; j<batch; ++j) {
+            op(k++);
+        }
+        if (now_s() - start >= MIN_SAMPLE_S) {
+            break;
+        }
+        batch *= 2;
+    }
+
+    vector<double> samples;
+    double total = 0;
+
+    while (samples.size() < MAX_SAMPLES &&
+            (samples.size() < MIN_SAMPLES || total < min_time_s)) {
+        const auto start = now_s();
+        for (size_t j=0; j<batch; ++j) {
+            op(k++);
+        }
+        const auto elapsed = now_s() - start;
+        samples.push_back(elapsed / batch);
+        total += elapsed;
+    }
+
+    return samples;
+}
+
+// Nearest-rank percentile of sorted values
+static double percentile(const vector<double> & sorted, const double p)
+{
+    const auto rank = (size_t)ceil(p / 100 * sorted.size());
+    return sorted[min(max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+static void shape(const size_t beams, int & width, int & height)
+{
+    const auto side = (int)round(sqrt((double)beams));
+
+    width = side * side == (int)beams ? side : beams;
+    height = side * side == (int)beams ? side : 1;
+}
+
+static vector<simsens::pose_t> random_poses(const size_t count,
+        const double size_m, mt19937 & rng)
+{
+    uniform_real_distribution<double> position(-size_m / 2, size_m / 2);
+    uniform_real_distribution<double> angle(-M_PI, M_PI);
+
+    vector<simsens::pose_t> poses(count);
+
+    for (auto & pose : poses) {
+        pose.x = position(rng);
+        pose.y = position(rng);
+        pose.z = 0.5;
+        pose.psi = angle(rng);
+    }
+
+    return poses;
+}
+
+static void print_result(FILE * fp, const result_t & result)
+{
+    auto sorted = result.seconds_per_op;
+    sort(sorted.begin(), sorted.end());
+
+    // A slower operation gives a lower rate, so rate percentiles come from
+    // the opposite end of the time distribution
+    fprintf(fp, "%-8s %-7s %7zu walls %5zu beams %-5s %-12s %12.4g %s/s"
+            "  (p10 %.4g  p90 %.4g)\n",
+            result.benchmark.c_str(), result.layout.c_str(),
+            result.walls, result.beams, result.accelerator.c_str(),
+            result.precision.c_str(),
+            result.work_per_op / percentile(sorted, 50),
+            result.unit.c_str(),
+            result.work_per_op / percentile(sorted, 90),
+            result.work_per_op / percentile(sorted, 10));
+
+    fflush(fp);
+}
+
+static void write_json(const char * file_name,
+        const vector<result_t> & results)
+{
+    auto fp = strcmp(file_name, "-") == 0 ? stdout : fopen(file_name, "w");
+
+    if (!fp) {
+        fprintf(stderr, "Unable to open file %s for output\n", file_name);
+        return;
+    }
+
+    fprintf(fp, "{\n  \"threads\": %zu,\n  \"results\": [\n",
+            simsens::ThreadPool::shared().size());
+
+    for (size_t k=0; k<results.size(); ++k) {
+
+        const auto & result = results[k];
+
+        auto sorted = result.seconds_per_op;
+        sort(sorted.begin(), sorted.end());
+
+        fprintf(fp, "    {\"benchmark\": \"%s\", \"layout\": \"%s\", "
+                "\"walls\": %zu, \"beams\": %zu, \"accelerator\": \"%s\", "
+                "\"precision\": \"%s\", \"unit\": \"%s/s\", \"samples\": %zu, "
+                "\"rate_p10\": %.6g, \"rate_p50\": %.6g, \"rate_p90\": %.6g, "
+                "\"seconds_p50\": %.6g, \"seconds_p90\": %.6g, "
+                "\"seconds_p99\": %.6g}%s\n",
+                result.benchmark.c_str(), result.layout.c_str(),
+                result.walls, result.beams, result.accelerator.c_str(),
+                result.precision.c_str(), result.unit.c_str(), sorted.size(),
+                result.work_per_op / percentile(sorted, 90),
+                result.work_per_op / percentile(sorted, 50),
+                result.work_per_op / percentile(sorted, 10),
+                percentile(sorted, 50), percentile(sorted, 90),
+                percentile(sorted, 99),
+                k + 1 < results.size() ? "," : "");
+    }
+
+    fprintf(fp, "  ]\n}\n");
+
+    if (fp != stdout) {
+        fclose(fp);
+    }
+}
+
+static void run_world(const options_t & options,
+        const Generator::layout_t layout, const size_t nwalls,
+        vector<result_t> & results)
+{
+    const auto world_text = Generator::world(layout, nwalls, options.seed);
+
+    char world_file_name[] = "/tmp/simsens-bench-XXXXXX";
+    const auto fd = mkstemp(world_file_name);
+
+    if (fd < 0 || !Generator::save(world_file_name, world_text)) {
+        return;
+    }
+
+    close(fd);
+
+    const auto megabytes = world_text.size() / 1e6;
+
+    const result_t base = {"", LAYOUT_NAMES[layout], nwalls, 0,
+        ACCELERATOR_NAMES[options.accelerator], "double", "", 0, {}};
+
+    // Each parse leaves its walls behind, so bound the number of samples
+    auto parse = base;
+    parse.benchmark = "parse";
+    parse.unit = "MB";
+    parse.work_per_op = megabytes;
+    parse.seconds_per_op = measure(0, [&world_file_name](const size_t) {
+            simsens::World world;
+            simsens::WorldParser::parse(world_file_name, world);
+            });
+    print_result(options.table, parse);
+    results.push_back(parse);
+
+    simsens::World world;
+    simsens::WorldParser::parse(world_file_name, world);
+    world.use_accelerator(options.accelerator);
+
+    remove(world_file_name);
+
+    mt19937 rng(options.seed);
+
+    const auto size_m = Generator::world_size_m(layout, nwalls);
+    const auto poses = random_poses(1024, size_m, rng);
+
+    auto collided = base;
+    collided.benchmark = "collided";
+    collided.unit = "queries";
+    collided.work_per_op = 1;
+    collided.seconds_per_op = measure(options.min_time_s,
+            [&world, &poses](const size_t k) {
+            const auto & pose = poses[k % poses.size()];
+            world.collided(simsens::vec3_t{pose.x, pose.y, pose.z});
+            });
+    print_result(options.table, collided);
+    results.push_back(collided);
+
+    for (auto beams : options.beams) {
+
+        int width = 0, height = 0;
+        shape(beams, width, height);
+
+        char robot_file_name[] = "/tmp/simsens-bench-XXXXXX";
+        const auto rfd = mkstemp(robot_file_name);
+
+        if (rfd < 0 || !Generator::save(robot_file_name,
+                    Generator::robot(width, height))) {
+            continue;
+        }
+
+        close(rfd);
+
+        simsens::Robot robot;
+        simsens::RobotParser::parse(robot_file_name, robot);
+        remove(robot_file_name);
+
+        auto rangefinder = robot.rangefinders.begin()->second;
+
+        rangefinder->noise.sigma_m = options.noise_sigma_m;
+        rangefinder->noise.dropout_probability =
+            options.noise_sigma_m > 0 ? 0.01 : 0;
+
+        vector<int> distances_mm(width * height);
+
+        auto read = base;
+        read.benchmark = "read";
+        read.beams = width * height;
+        read.precision = string(options.single_precision ? "float" : "double") +
+            (options.noise_sigma_m > 0 ? "+noise" : "");
+        read.unit = "beams";
+        read.work_per_op = width * height;
+        read.seconds_per_op = measure(options.min_time_s,
+                [&](const size_t k) {
+                const auto & pose = poses[k % poses.size()];
+                if (options.single_precision) {
+                    rangefinder->read<float>(pose, world, distances_mm.data());
+                }
+                else {
+                    rangefinder->read(pose, world, distances_mm.data());
+                }
+                });
+        print_result(options.table, read);
+        results.push_back(read);
+    }
+}
+
+static vector<size_t> parse_list(const char * text)
+{
+    vector<size_t> values;
+
+    for (auto p = text; *p; ) {
+
+        char * end = nullptr;
+        const auto value = strtoul(p, &end, 10);
+
+        if (end == p) {
+            break;
+        }
+
+        values.push_back(value);
+        p = *end == ',' ? end + 1 : end;
+    }
+
+    return values;
+}
+
+static void usage(const char * name)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --walls N,...       wall counts (default 10,1000,100000)\n"
+            "  --beams N,...       beams per sensor; a square count gives a\n"
+            "                      square image (default 1,64,4096)\n"
+            "  --layout L          random, maze, or both (default both)\n"
+            "  --accelerator A     none, grid, bvh, or field (default grid)\n"
+            "  --float             read in single precision\n"
+            "  --noise S           add Gaussian noise of S meters and 1%%\n"
+            "                      dropout to reads (default none)\n"
+            "  --time S            seconds per benchmark (default 0.25)\n"
+            "  --seed N            world generator seed (default 1)\n"
+            "  --json FILE         also write results as JSON; - for stdout\n"
+            "  --trace FILE        write a Chrome trace and print counters;\n"
+            "                      needs a build with PROFILE=1\n",
+            name);
+}
+
+int main(int argc, char ** argv)
+{
+    options_t options = {
+        {Generator::LAYOUT_RANDOM, Generator::LAYOUT_MAZE},
+        {10, 1000, 100000},
+        {1, 64, 4096},
+        simsens::ACCELERATOR_GRID,
+        false,
+        0,
+        0.25,
+        1,
+        nullptr,
+        nullptr,
+        stdout
+    };
+
+    for (int k=1; k<argc; ++k) {
+
+        const auto arg = argv[k];
+
+        if (!strcmp(arg, "--float")) {
+            options.single_precision = true;
+            continue;
+        }
+
+        const auto value = k + 1 < argc ? argv[k+1] : nullptr;
+
+        if (!value) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        if (!strcmp(arg, "--walls")) {
+            options.walls = parse_list(value);
+        }
+        else if (!strcmp(arg, "--beams")) {
+            options.beams = parse_list(value);
+        }
+        else if (!strcmp(arg, "--layout")) {
+            options.layouts.clear();
+            if (strcmp(value, "maze")) {
+                options.layouts.push_back(Generator::LAYOUT_RANDOM);
+            }
+            if (strcmp(value, "random")) {
+                options.layouts.push_back(Generator::LAYOUT_MAZE);
+            }
+        }
+        else if (!strcmp(arg, "--accelerator")) {
+            options.accelerator =
+                !strcmp(value, "none") ? simsens::ACCELERATOR_NONE :
+                !strcmp(value, "bvh") ? simsens::ACCELERATOR_BVH :
+                !strcmp(value, "field") ? simsens::ACCELERATOR_DISTANCE_FIELD :
+                simsens::ACCELERATOR_GRID;
+        }
+        else if (!strcmp(arg, "--noise")) {
+            options.noise_sigma_m = atof(value);
+        }
+        else if (!strcmp(arg, "--time")) {
+            options.min_time_s = atof(value);
+        }
+        else if (!strcmp(arg, "--seed")) {
+            options.seed = atoi(value);
+        }
+        else if (!strcmp(arg, "--json")) {
+            options.json_file_name = value;
+        }
+        else if (!strcmp(arg, "--trace")) {
+            options.trace_file_name = value;
+        }
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+
+        k++;
+    }
+
+    if (options.trace_file_name && !simsens::Profiler::ENABLED) {
+        fprintf(stderr, "--trace needs a build with SIMSENS_PROFILE defined\n");
+        return 1;
+    }
+
+    // Keep stdout clean for JSON
+    if (options.json_file_name && !strcmp(options.json_file_name, "-")) {
+        options.table = stderr;
+    }
+
+    vector<result_t> results;
+
+    for (auto layout : options.layouts) {
+        for (auto nwalls : options.walls) {
+            run_world(options, layout, nwalls, results);
+        }
+    }
+
+    if (options.json_file_name) {
+        write_json(options.json_file_name, results);
+    }
+
+    if (options.trace_file_name) {
+        simsens::Profiler::write_chrome_trace(options.trace_file_name);
+        simsens::Profiler::dump();
+    }
+
+    return 0;
+}
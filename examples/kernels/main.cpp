@@ -0,0 +1,242 @@
+/*
+   Checks the beam-versus-wall kernel against a scalar reference
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <random>
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/simd.hpp>
+
+// Documented bound on how far the double kernel can stray from the
+// reference; the float kernel is held to the millimeter its reads report
+static constexpr double DOUBLE_TOLERANCE_M = 1e-9;
+static constexpr double FLOAT_TOLERANCE_M = 1e-3;
+
+// Beams that graze a wall's end can hit it in one computation and miss it
+// in the other; allow this small a fraction of them
+static constexpr double MAX_GRAZING_FRACTION = 1e-4;
+
+// Counts that leave every number of leftover walls after the vector loops
+static const size_t WALL_COUNTS[] = {1, 2, 3, 5, 7, 8, 13, 100, 1001};
+
+static constexpr int BEAMS = 2000;
+
+static constexpr double REACH_M = 30;
+
+#if defined(SIMSENS_AVX2)
+static const char * KERNEL_NAME = "avx2";
+#elif defined(SIMSENS_SSE2)
+static const char * KERNEL_NAME = "sse2";
+#else
+static const char * KERNEL_NAME = "scalar";
+#endif
+
+// https://gist.github.com/kylemcdonald/6132fc1c29fd3767691442ba4bc84018
+static bool line_segments_intersect(
+        const double x1, const double y1,
+        const double x2, const double y2,
+        const double x3, const double y3,
+        const double x4, const double y4,
+        double & px, double & py)
+{
+    const auto denom = (y4 - y3) * (x2 - x1) - (x4 - x3) * (y2 - y1);
+
+    if (denom != 0) {
+
+        const auto ua = ((x4 - x3) * (y1 - y3) - (y4 - y3) * (x1 - x3)) / denom;
+        const auto ub = ((x2 - x1) * (y1 - y3) - (y2 - y1) * (x1 - x3)) / denom;
+
+        // Check if intersection point lies within both line segments (0 <=
+        // ua <= 1 and 0 <= ub <= 1)
+        if (0 <= ua && ua <= 1 && 0 <= ub && ub <= 1) {
+
+            px = x1 + ua * (x2 - x1);
+            py = y1 + ua * (y2 - y1);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// The original per-beam wall test, trigonometry and all, that the cached
+// segments and the kernel replaced
+static double intersect_with_wall(
+        const simsens::vec3_t robot_location,
+        const double azimuth_angle,
+        const double elevation_angle,
+        const double reach_m,
+        const simsens::Wall & wall)
+{
+    // Calculate beam endpoints
+    const auto beam_end_x = robot_location.x + cos(azimuth_angle) * reach_m;
+    const auto beam_end_y = robot_location.y - sin(azimuth_angle) * reach_m;
+
+    // Get wall endpoints
+    const auto psi = wall.rotation.alpha; // rot.  always 0 0 1 alpha
+    const auto len = wall.size.y / 2;
+    const auto wall_dx = len * sin(psi);
+    const auto wall_dy = len * cos(psi);
+    const auto wall_tx = wall.translation.x;
+    const auto wall_ty = wall.translation.y;
+
+    // If beam ((x1,y1),(x2,y2)) intersects with with wall
+    // ((x3,y3),(x4,y4))
+    double px = 0, py = 0;
+    if (line_segments_intersect(
+                robot_location.x, robot_location.y,
+                beam_end_x, beam_end_y,
+                wall_tx + wall_dx, wall_ty + wall_dy,
+                wall_tx - wall_dx, wall_ty - wall_dy,
+                px, py)) {
+
+        // Use intersection (px,py) to calculate XY distance to wall
+        const auto dx = robot_location.x - px;
+        const auto dy = robot_location.y - py;
+        const auto xydist = sqrt(dx*dx + dy*dy);
+
+        // Use XY distance, robot Z, and elevation angle to calculate Z
+        // offset of intersection on wall w.r.t. robot Z
+        const auto dz = -tan(elevation_angle) * xydist;
+
+        // Calculate XYZ distance by including Z offset and wall
+        // thickness
+        const auto xyzdist = sqrt(dx*dx + dy*dy + dz*dz) - wall.size.x / 2;
+
+        // If Z is below wall, the beam hits it
+        if (robot_location.z + dz < wall.size.z) {
+            return xyzdist;
+        }
+    }
+
+    return INFINITY;
+}
+
+// Whether the kernel's distance is the reference's, to within the
+// tolerance, and the wall it reports is the nearest or just as near;
+// reported is the reference's distance to that wall
+static bool agrees(const double dist, const double reported,
+        const double expected, const double tolerance)
+{
+    if (isinf(dist) || isinf(expected)) {
+        return isinf(dist) && isinf(expected);
+    }
+
+    return fabs(dist - expected) <= tolerance &&
+        fabs(reported - expected) <= tolerance;
+}
+
+// Returns true if both precisions' kernels agree with the reference
+static bool check(const size_t nwalls)
+{
+    mt19937 rng(nwalls);
+    uniform_real_distribution<double> position(-10, 10);
+    uniform_real_distribution<double> angle(-M_PI, M_PI);
+    uniform_real_distribution<double> pitch(-0.3, 0.3);
+    uniform_real_distribution<double> length(0.5, 4);
+    uniform_real_distribution<double> height(0.2, 3);
+
+    vector<simsens::Wall> walls(nwalls);
+
+    for (auto & wall : walls) {
+        wall.translation = {position(rng), position(rng), 0};
+        wall.rotation = {0, 0, 1, angle(rng)};
+        wall.size = {0.1, length(rng), height(rng)};
+    }
+
+    simsens::WallSegments segments;
+    segments.build(walls);
+
+    simsens::BasicWallSegments<float> float_segments;
+    float_segments.assign(segments);
+
+    size_t hits = 0;
+    size_t grazing[2] = {};
+
+    for (int b=0; b<BEAMS; ++b) {
+
+        const simsens::vec3_t location = {position(rng), position(rng), 1};
+        const auto azimuth = angle(rng);
+        const auto elevation = pitch(rng);
+
+        // Reference distance to wall k, INFINITY past the last
+        auto reference = [&](const size_t k) {
+            return k < nwalls ? intersect_with_wall(location, azimuth,
+                    elevation, REACH_M, walls[k]) : INFINITY;
+        };
+
+        double expected = INFINITY;
+
+        for (size_t k=0; k<nwalls; ++k) {
+            expected = min(expected, reference(k));
+        }
+
+        hits += expected < INFINITY;
+
+        auto beam = simsens::make_beam(location, cos(azimuth), sin(azimuth),
+                REACH_M);
+        beam.tan_elevation = tan(elevation);
+
+        size_t index = 0;
+        const auto dist = simsens::nearest_segment_on_beam(beam, segments,
+                index);
+
+        grazing[0] += !agrees(dist, reference(index), expected,
+                DOUBLE_TOLERANCE_M);
+
+        const auto float_dist = simsens::nearest_segment_on_beam(
+                simsens::beam_cast<float>(beam), float_segments, index);
+
+        grazing[1] += !agrees(float_dist, reference(index), expected,
+                FLOAT_TOLERANCE_M);
+    }
+
+    const auto ok = grazing[0] <= MAX_GRAZING_FRACTION * BEAMS &&
+        grazing[1] <= MAX_GRAZING_FRACTION * BEAMS;
+
+    printf("%-6s %5zu walls: %5d beams, %5zu hits, %zu double and %zu float "
+            "beyond tolerance  %s\n",
+            KERNEL_NAME, nwalls, BEAMS, hits, grazing[0], grazing[1],
+            ok ? "ok" : "FAILED");
+
+    return ok;
+}
+
+int main()
+{
+#if defined(SIMSENS_AVX2)
+    if (!__builtin_cpu_supports("avx2")) {
+        printf("avx2 kernel: skipped, as this CPU lacks AVX2\n");
+        return 0;
+    }
+#endif
+
+    bool ok = true;
+
+    for (const auto nwalls : WALL_COUNTS) {
+        ok = check(nwalls) && ok;
+    }
+
+    printf("%s\n", ok ? "PASSED" : "FAILED");
+
+    return ok ? 0 : 1;
+}
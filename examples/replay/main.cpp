@@ -0,0 +1,118 @@
+/*
+   Records a flight's scans to a log, then replays the log and checks it
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <simsensors/src/parsers/webots/world.hpp>
+#include <simsensors/src/parsers/webots/robot.hpp>
+#include <simsensors/src/recording/reader.hpp>
+#include <simsensors/src/recording/writer.hpp>
+#include <simsensors/src/world.hpp>
+
+static const char * LOG_FILE_NAME = "flight.log";
+
+static constexpr double TICK_S = 0.001;
+static constexpr double DURATION_S = 20;
+
+// Rates of a VL53L5 and a VL53L1
+static constexpr double MULTIZONE_RATE_HZ = 15;
+static constexpr double SINGLE_ZONE_RATE_HZ = 50;
+
+// A slow circle around the world's origin, turning as it goes
+static simsens::pose_t flight_pose(const double t)
+{
+    const auto angle = 2 * M_PI * t / DURATION_S;
+
+    return simsens::pose_t {0.5 * cos(angle), 0.5 * sin(angle), 0.5,
+        0, 0, angle};
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s WORLDFILE ROBOTFILE\n", argv[0]);
+        return 1;
+    }
+
+    simsens::World world;
+    simsens::WorldParser::parse(argv[1], world);
+
+    simsens::Robot robot;
+    simsens::RobotParser::parse(argv[2], robot);
+
+    for (auto entry : robot.rangefinders) {
+        robot.schedule(entry.first, entry.second->height * entry.second->width
+                > 1 ? MULTIZONE_RATE_HZ : SINGLE_ZONE_RATE_HZ);
+    }
+
+    simsens::ScanLogWriter writer;
+
+    if (!writer.open(LOG_FILE_NAME, robot)) {
+        return 1;
+    }
+
+    // Log only the ticks that read something
+    for (double t=0; t<DURATION_S; t+=TICK_S) {
+
+        const auto pose = flight_pose(t);
+
+        if (robot.tick(t, pose, world) > 0) {
+            writer.record(t, pose,
+                    world.collided(simsens::vec3_t{pose.x, pose.y, pose.z}),
+                    robot);
+        }
+    }
+
+    if (!writer.close()) {
+        return 1;
+    }
+
+    simsens::ScanLogReader reader(LOG_FILE_NAME);
+
+    if (!reader.valid()) {
+        fprintf(stderr, "Unable to read %s\n", LOG_FILE_NAME);
+        return 1;
+    }
+
+    const auto middle = reader.find(DURATION_S / 2);
+
+    printf("%zu records; first at or after %.1fs is #%zu at %.3fs\n",
+            reader.size(), DURATION_S / 2, middle, reader.time(middle));
+
+    bool passed = reader.size() > 0;
+
+    for (size_t k=0; k<reader.sensor_count(); ++k) {
+
+        const auto & sensor = reader.sensor(k);
+
+        const auto result = reader.replay(k,
+                *robot.rangefinders[sensor.name], world);
+
+        printf("%-16s %3dx%-3d %6zu frames, %zu of %zu beams differ, "
+                "max error %d mm\n",
+                sensor.name, sensor.width, sensor.height, result.frames,
+                result.mismatched_beams, result.beams, result.max_error_mm);
+
+        passed = passed && result.frames > 0 && result.mismatched_beams == 0;
+    }
+
+    printf("%s\n", passed ? "PASSED" : "FAILED");
+
+    return passed ? 0 : 1;
+}
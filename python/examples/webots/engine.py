@@ -0,0 +1,47 @@
+#!/usr/bin/python3
+'''
+Copyright (C) 2026 Simon D. Levy
+
+This program is free software: you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation, in version 3.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program. If not, see <http:--www.gnu.org/licenses/>.
+'''
+
+import numpy as np
+
+from simsensors.engine import World, Robot
+
+DATADIR = '../../../data/webots/'
+
+WORLD = DATADIR + 'twoexit.wbt'
+ROBOT = DATADIR + 'DiyQuad.proto'
+
+world = World(WORLD)
+robot = Robot(ROBOT)
+
+rangefinder = robot.rangefinders['VL53L5-forward']
+
+pose = (0, 0, 0.5, 0, 0, 0)
+
+# A new int32 image in millimeters, -1 for no return
+print(rangefinder.read(pose, world))
+
+# Or written into an existing array; float arrays get meters
+meters = np.empty((rangefinder.height, rangefinder.width), dtype=np.float32)
+rangefinder.read(pose, world, out=meters)
+print(meters)
+
+# Many poses at once, as an (N, 6) array of x, y, z, phi, theta, psi
+poses = np.zeros((100, 6))
+poses[:, 2] = 0.5
+poses[:, 5] = np.linspace(-np.pi, np.pi, len(poses))
+print(rangefinder.read_batch(poses, world).shape)
+
+print(world.collided(0, 0, 0.5))
@@ -13,7 +13,22 @@ You should have received a copy of the GNU General Public License along with
 this program. If not, see <http:--www.gnu.org/licenses/>.
 '''
 
-from distutils.core import setup
+import os
+
+from setuptools import setup, Extension
+
+# Like the examples' Makefiles, the C++ headers are included as
+# <simsensors/src/...>, from the directory holding this repository
+ROOTDIR = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..'))
+
+engine = Extension('simsensors.engine',
+                   sources=['simsensors/engine.cpp'],
+                   include_dirs=[ROOTDIR],
+                   extra_compile_args=['-O3', '-std=c++17'],
+                   extra_link_args=['-pthread'],
+                   language='c++')
 
 setup(name='simsensors',
-      packages=['simsensors'])
+      packages=['simsensors'],
+      install_requires=['numpy'],
+      ext_modules=[engine])
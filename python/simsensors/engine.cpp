@@ -0,0 +1,967 @@
+/*
+   CPython bindings for the C++ world, robot, and rangefinder engine
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+// Scans are written straight into any writable buffer (a numpy array,
+// typically) through its strides, so nothing is copied.  The module needs
+// no numpy headers to build: it talks to arrays through the buffer
+// protocol, and imports numpy only to allocate arrays it returns.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/parsers/webots/world.hpp>
+#include <simsensors/src/parsers/webots/robot.hpp>
+#include <simsensors/src/robot.hpp>
+#include <simsensors/src/world.hpp>
+
+// Rangefinder reads walk the world with the GIL released, so readers
+// counts those in flight, and the world refuses changes while there are any
+typedef struct {
+    PyObject_HEAD
+    simsens::World * world;
+    Py_ssize_t readers;
+} WorldObject;
+
+typedef struct {
+    PyObject_HEAD
+    simsens::Robot * robot;
+    PyObject * rangefinders;
+} RobotObject;
+
+// A read updates its sensor's noise and coherence state with the GIL
+// released, so busy keeps a second thread from reading the same sensor
+typedef struct {
+    PyObject_HEAD
+    simsens::Rangefinder * rangefinder;
+    PyObject * robot;
+    bool busy;
+} RangefinderObject;
+
+static PyTypeObject WorldType = {PyVarObject_HEAD_INIT(NULL, 0)};
+static PyTypeObject RobotType = {PyVarObject_HEAD_INIT(NULL, 0)};
+static PyTypeObject RangefinderType = {PyVarObject_HEAD_INIT(NULL, 0)};
+
+// The parsers report a missing file on stderr and carry on, so check first
+static bool check_readable(const char * file_name)
+{
+    auto fp = fopen(file_name, "r");
+
+    if (!fp) {
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, file_name);
+        return false;
+    }
+
+    fclose(fp);
+
+    return true;
+}
+
+static bool parse_vec3(PyObject * arg, simsens::vec3_t & v)
+{
+    return PyArg_ParseTuple(arg, "ddd", &v.x, &v.y, &v.z);
+}
+
+static bool parse_pose(PyObject * arg, simsens::pose_t & pose)
+{
+    auto tuple = PySequence_Tuple(arg);
+
+    if (!tuple) {
+        return false;
+    }
+
+    const auto ok = PyArg_ParseTuple(tuple,
+            "dddddd;pose must be (x, y, z, phi, theta, psi)",
+            &pose.x, &pose.y, &pose.z, &pose.phi, &pose.theta, &pose.psi);
+
+    Py_DECREF(tuple);
+
+    return ok;
+}
+
+// Skips a buffer format's byte-order and alignment prefix
+static const char * plain_format(const Py_buffer & view)
+{
+    auto format = view.format ? view.format : "B";
+
+    while (*format && strchr("@=<>!", *format)) {
+        format++;
+    }
+
+    return format;
+}
+
+// Allocates an uninitialized int32 numpy array of the given shape
+static PyObject * new_array(const Py_ssize_t frames, const int height,
+        const int width)
+{
+    static PyObject * empty = nullptr;
+
+    if (!empty) {
+        auto numpy = PyImport_ImportModule("numpy");
+        if (!numpy) {
+            return nullptr;
+        }
+        empty = PyObject_GetAttrString(numpy, "empty");
+        Py_DECREF(numpy);
+        if (!empty) {
+            return nullptr;
+        }
+    }
+
+    auto shape = frames < 0 ?
+        Py_BuildValue("(ii)", height, width) :
+        Py_BuildValue("(nii)", frames, height, width);
+
+    if (!shape) {
+        return nullptr;
+    }
+
+    auto array = PyObject_CallFunction(empty, "Os", shape, "int32");
+
+    Py_DECREF(shape);
+
+    return array;
+}
+
+// Describes a writable buffer of the given shape as a rangefinder output:
+// int32, uint16 and uint8 get millimeters, float32 and float64 meters
+static bool make_output(const Py_buffer & view,
+        const Py_ssize_t frames, const int height, const int width,
+        simsens::RangefinderOutput & output)
+{
+    const auto ndim = frames < 0 ? 2 : 3;
+
+    if (view.ndim != ndim ||
+            (ndim == 3 && view.shape[0] != frames) ||
+            view.shape[ndim-2] != height || view.shape[ndim-1] != width) {
+        PyErr_Format(PyExc_ValueError,
+                "output must have shape %s(%d, %d)",
+                ndim == 3 ? "(frames) + " : "", height, width);
+        return false;
+    }
+
+    const auto format = plain_format(view);
+
+    simsens::RangefinderOutput::type_t type =
+        simsens::RangefinderOutput::TYPE_INT32;
+
+    if (strchr("il", *format) && view.itemsize == 4) {
+        type = simsens::RangefinderOutput::TYPE_INT32;
+    }
+    else if (*format == 'H' && view.itemsize == 2) {
+        type = simsens::RangefinderOutput::TYPE_UINT16;
+    }
+    else if (*format == 'B' && view.itemsize == 1) {
+        type = simsens::RangefinderOutput::TYPE_UINT8;
+    }
+    else if (*format == 'f' && view.itemsize == 4) {
+        type = simsens::RangefinderOutput::TYPE_FLOAT32;
+    }
+    else if (*format == 'd' && view.itemsize == 8) {
+        type = simsens::RangefinderOutput::TYPE_FLOAT64;
+    }
+    else {
+        PyErr_SetString(PyExc_TypeError,
+                "output must be int32, uint16, uint8, float32 or float64");
+        return false;
+    }
+
+    const auto meters = type == simsens::RangefinderOutput::TYPE_FLOAT32 ||
+        type == simsens::RangefinderOutput::TYPE_FLOAT64;
+
+    output.distances(view.buf, type,
+            meters ? simsens::RangefinderOutput::UNIT_METERS :
+            simsens::RangefinderOutput::UNIT_MILLIMETERS,
+            view.strides[ndim-1], view.strides[ndim-2],
+            ndim == 3 ? view.strides[0] : 0);
+
+    return true;
+}
+
+// World ----------------------------------------------------------------------
+
+static PyObject * World_new(PyTypeObject * type, PyObject *, PyObject *)
+{
+    auto self = (WorldObject *)type->tp_alloc(type, 0);
+
+    if (self) {
+        self->world = new simsens::World();
+        self->readers = 0;
+    }
+
+    return (PyObject *)self;
+}
+
+// Whether the world can be changed; only called with the GIL held
+static bool check_idle(WorldObject * self)
+{
+    if (self->readers > 0) {
+        PyErr_SetString(PyExc_RuntimeError,
+                "World can't change while another thread reads it");
+        return false;
+    }
+
+    return true;
+}
+
+static int World_init(WorldObject * self, PyObject * args, PyObject * kwds)
+{
+    static const char * keywords[] = {"world_file", "robot_file", nullptr};
+
+    const char * world_file_name = nullptr;
+    const char * robot_file_name = "";
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|s", (char **)keywords,
+                &world_file_name, &robot_file_name) ||
+            !check_readable(world_file_name) || !check_idle(self)) {
+        return -1;
+    }
+
+    simsens::WorldParser::parse(world_file_name, *self->world,
+            robot_file_name);
+
+    return 0;
+}
+
+static void World_dealloc(WorldObject * self)
+{
+    delete self->world;
+
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject * World_collided(WorldObject * self, PyObject * args)
+{
+    simsens::vec3_t location = {};
+
+    if (!parse_vec3(args, location)) {
+        return nullptr;
+    }
+
+    return PyBool_FromLong(self->world->collided(location));
+}
+
+static PyObject * World_clearance(WorldObject * self, PyObject * args)
+{
+    simsens::vec3_t location = {};
+    double radius_m = 0;
+
+    if (!PyArg_ParseTuple(args, "ddd|d", &location.x, &location.y,
+                &location.z, &radius_m)) {
+        return nullptr;
+    }
+
+    const auto collision = self->world->clearance(location, radius_m);
+
+    return Py_BuildValue("(di)", collision.clearance_m,
+            collision.wall_index);
+}
+
+static PyObject * World_field_distance(WorldObject * self, PyObject * args)
+{
+    simsens::vec3_t location = {};
+
+    if (!parse_vec3(args, location)) {
+        return nullptr;
+    }
+
+    simsens::vec3_t gradient = {};
+
+    const auto distance = self->world->field_distance(location, &gradient);
+
+    return Py_BuildValue("(ddd)", distance, gradient.x, gradient.y);
+}
+
+static PyObject * World_use_accelerator(WorldObject * self, PyObject * args)
+{
+    const char * name = nullptr;
+    double cell_size_m = 0;
+
+    if (!PyArg_ParseTuple(args, "s|d", &name, &cell_size_m)) {
+        return nullptr;
+    }
+
+    simsens::accelerator_t type = simsens::ACCELERATOR_NONE;
+
+    if (!strcmp(name, "grid")) {
+        type = simsens::ACCELERATOR_GRID;
+    }
+    else if (!strcmp(name, "bvh")) {
+        type = simsens::ACCELERATOR_BVH;
+    }
+    else if (!strcmp(name, "field")) {
+        type = simsens::ACCELERATOR_DISTANCE_FIELD;
+    }
+    else if (strcmp(name, "none")) {
+        PyErr_SetString(PyExc_ValueError,
+                "accelerator must be 'none', 'grid', 'bvh' or 'field'");
+        return nullptr;
+    }
+
+    if (!check_idle(self)) {
+        return nullptr;
+    }
+
+    self->world->use_accelerator(type, cell_size_m);
+
+    Py_RETURN_NONE;
+}
+
+// Obstacle handles are (kind, index) tuples, kind being 'wall', 'box' or
+// 'cylinder'
+static const char * OBSTACLE_KINDS[] = {"wall", "box", "cylinder"};
+
+static PyObject * build_obstacle(const simsens::obstacle_t & obstacle)
+{
+    return Py_BuildValue("(sI)", OBSTACLE_KINDS[obstacle.type],
+            obstacle.index);
+}
+
+static bool parse_obstacle(PyObject * handle, simsens::obstacle_t & obstacle)
+{
+    const char * kind = nullptr;
+    unsigned int index = 0;
+
+    if (!PyArg_ParseTuple(handle, "sI", &kind, &index)) {
+        return false;
+    }
+
+    for (int k=0; k<3; ++k) {
+        if (!strcmp(kind, OBSTACLE_KINDS[k])) {
+            obstacle = {(simsens::obstacle_type_t)k, index};
+            return true;
+        }
+    }
+
+    PyErr_SetString(PyExc_ValueError,
+            "obstacle kind must be 'wall', 'box' or 'cylinder'");
+
+    return false;
+}
+
+static PyObject * World_insert_wall(WorldObject * self, PyObject * args)
+{
+    simsens::vec3_t t = {}, size = {};
+    simsens::rotation_t r = {};
+    const char * name = "";
+
+    if (!PyArg_ParseTuple(args, "(ddd)(dddd)(ddd)|s", &t.x, &t.y, &t.z,
+                &r.x, &r.y, &r.z, &r.alpha, &size.x, &size.y, &size.z,
+                &name)) {
+        return nullptr;
+    }
+
+    if (!check_idle(self)) {
+        return nullptr;
+    }
+
+    return build_obstacle(self->world->insert_wall(t, r, size, name));
+}
+
+static PyObject * World_insert_box(WorldObject * self, PyObject * args)
+{
+    simsens::vec3_t t = {}, size = {};
+    simsens::rotation_t r = {};
+    const char * name = "";
+
+    if (!PyArg_ParseTuple(args, "(ddd)(dddd)(ddd)|s", &t.x, &t.y, &t.z,
+                &r.x, &r.y, &r.z, &r.alpha, &size.x, &size.y, &size.z,
+                &name)) {
+        return nullptr;
+    }
+
+    if (!check_idle(self)) {
+        return nullptr;
+    }
+
+    return build_obstacle(self->world->insert_box(t, r, size, name));
+}
+
+static PyObject * World_insert_cylinder(WorldObject * self, PyObject * args)
+{
+    simsens::vec3_t t = {};
+    double radius = 0, height = 0;
+    const char * name = "";
+
+    if (!PyArg_ParseTuple(args, "(ddd)dd|s", &t.x, &t.y, &t.z,
+                &radius, &height, &name)) {
+        return nullptr;
+    }
+
+    if (!check_idle(self)) {
+        return nullptr;
+    }
+
+    return build_obstacle(
+            self->world->insert_cylinder(t, radius, height, name));
+}
+
+static PyObject * World_find_obstacle(WorldObject * self, PyObject * args)
+{
+    const char * name = nullptr;
+
+    if (!PyArg_ParseTuple(args, "s", &name)) {
+        return nullptr;
+    }
+
+    simsens::obstacle_t obstacle = {};
+
+    if (!self->world->find_obstacle(name, obstacle)) {
+        Py_RETURN_NONE;
+    }
+
+    return build_obstacle(obstacle);
+}
+
+static PyObject * World_move_obstacle(WorldObject * self, PyObject * args)
+{
+    PyObject * handle = nullptr;
+    simsens::vec3_t t = {};
+    simsens::rotation_t r = {0, 0, 1, 0};
+
+    if (!PyArg_ParseTuple(args, "O!(ddd)|(dddd)", &PyTuple_Type, &handle,
+                &t.x, &t.y, &t.z, &r.x, &r.y, &r.z, &r.alpha)) {
+        return nullptr;
+    }
+
+    simsens::obstacle_t obstacle = {};
+
+    if (!parse_obstacle(handle, obstacle) || !check_idle(self)) {
+        return nullptr;
+    }
+
+    return PyBool_FromLong(self->world->move_obstacle(obstacle, t, r));
+}
+
+static PyObject * World_remove_obstacle(WorldObject * self, PyObject * args)
+{
+    PyObject * handle = nullptr;
+
+    if (!PyArg_ParseTuple(args, "O!", &PyTuple_Type, &handle)) {
+        return nullptr;
+    }
+
+    simsens::obstacle_t obstacle = {};
+
+    if (!parse_obstacle(handle, obstacle) || !check_idle(self)) {
+        return nullptr;
+    }
+
+    return PyBool_FromLong(self->world->remove_obstacle(obstacle));
+}
+
+static PyObject * World_robot_pose(WorldObject * self, PyObject *)
+{
+    const auto pose = self->world->getRobotPose();
+
+    return Py_BuildValue("(dddddd)", pose.x, pose.y, pose.z,
+            pose.phi, pose.theta, pose.psi);
+}
+
+static PyMethodDef World_methods[] = {
+    {"collided", (PyCFunction)World_collided, METH_VARARGS,
+        "collided(x, y, z) -> whether the location is within tolerance of "
+            "a wall"},
+    {"clearance", (PyCFunction)World_clearance, METH_VARARGS,
+        "clearance(x, y, z, radius=0) -> (distance to the nearest wall, "
+            "its id)"},
+    {"use_accelerator", (PyCFunction)World_use_accelerator, METH_VARARGS,
+        "use_accelerator('none' | 'grid' | 'bvh' | 'field', cell_size=0)"},
+    {"field_distance", (PyCFunction)World_field_distance, METH_VARARGS,
+        "field_distance(x, y, z) -> (distance, gradient x, gradient y) "
+            "interpolated from the distance field"},
+    {"insert_wall", (PyCFunction)World_insert_wall, METH_VARARGS,
+        "insert_wall(translation, rotation, size, name='') -> handle of a "
+            "new wall"},
+    {"insert_box", (PyCFunction)World_insert_box, METH_VARARGS,
+        "insert_box(translation, rotation, size, name='') -> handle of a "
+            "new box"},
+    {"insert_cylinder", (PyCFunction)World_insert_cylinder, METH_VARARGS,
+        "insert_cylinder(translation, radius, height, name='') -> handle "
+            "of a new cylinder"},
+    {"find_obstacle", (PyCFunction)World_find_obstacle, METH_VARARGS,
+        "find_obstacle(name) -> (kind, index) handle of the named wall, "
+            "box or cylinder, or None"},
+    {"move_obstacle", (PyCFunction)World_move_obstacle, METH_VARARGS,
+        "move_obstacle(handle, translation, rotation=(0, 0, 1, 0)) -> "
+            "whether there was such an obstacle"},
+    {"remove_obstacle", (PyCFunction)World_remove_obstacle, METH_VARARGS,
+        "remove_obstacle(handle) -> whether there was such an obstacle"},
+    {"robot_pose", (PyCFunction)World_robot_pose, METH_NOARGS,
+        "robot_pose() -> the robot's (x, y, z, phi, theta, psi) in the "
+            "world file"},
+    {nullptr}
+};
+
+// Rangefinder ----------------------------------------------------------------
+
+static int Rangefinder_clear(RangefinderObject * self);
+
+static void Rangefinder_dealloc(RangefinderObject * self)
+{
+    PyObject_GC_UnTrack(self);
+
+    Rangefinder_clear(self);
+
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static bool get_world(PyObject * arg, WorldObject * & world)
+{
+    if (!PyObject_TypeCheck(arg, &WorldType)) {
+        PyErr_SetString(PyExc_TypeError, "world must be a simsensors World");
+        return false;
+    }
+
+    world = (WorldObject *)arg;
+
+    return true;
+}
+
+// Gets the output buffer passed in, or allocates one
+static PyObject * get_output(PyObject * out, const Py_ssize_t frames,
+        const int height, const int width, Py_buffer & view)
+{
+    auto array = out && out != Py_None ?
+        (Py_INCREF(out), out) : new_array(frames, height, width);
+
+    if (!array) {
+        return nullptr;
+    }
+
+    if (PyObject_GetBuffer(array, &view,
+                PyBUF_STRIDES | PyBUF_FORMAT | PyBUF_WRITABLE) < 0) {
+        Py_DECREF(array);
+        return nullptr;
+    }
+
+    return array;
+}
+
+// Claims the sensor for a read; only called with the GIL held
+static bool claim(RangefinderObject * self)
+{
+    if (self->busy) {
+        PyErr_SetString(PyExc_RuntimeError,
+                "Rangefinder is being read by another thread");
+        return false;
+    }
+
+    self->busy = true;
+
+    return true;
+}
+
+static PyObject * Rangefinder_read(RangefinderObject * self,
+        PyObject * args, PyObject * kwds)
+{
+    static const char * keywords[] = {"pose", "world", "out", nullptr};
+
+    PyObject * pose_arg = nullptr;
+    PyObject * world_arg = nullptr;
+    PyObject * out = nullptr;
+
+    simsens::pose_t pose = {};
+    WorldObject * world = nullptr;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO|O", (char **)keywords,
+                &pose_arg, &world_arg, &out) ||
+            !parse_pose(pose_arg, pose) || !get_world(world_arg, world)) {
+        return nullptr;
+    }
+
+    auto rangefinder = self->rangefinder;
+
+    Py_buffer view = {};
+    auto array = get_output(out, -1, rangefinder->height, rangefinder->width,
+            view);
+
+    if (!array) {
+        return nullptr;
+    }
+
+    simsens::RangefinderOutput output;
+
+    if (!make_output(view, -1, rangefinder->height, rangefinder->width,
+                output) || !claim(self)) {
+        PyBuffer_Release(&view);
+        Py_DECREF(array);
+        return nullptr;
+    }
+
+    world->readers++;
+
+    Py_BEGIN_ALLOW_THREADS
+    rangefinder->read(pose, *world->world, output);
+    Py_END_ALLOW_THREADS
+
+    world->readers--;
+    self->busy = false;
+
+    PyBuffer_Release(&view);
+
+    return array;
+}
+
+static PyObject * Rangefinder_read_batch(RangefinderObject * self,
+        PyObject * args, PyObject * kwds)
+{
+    static const char * keywords[] = {"poses", "world", "out", nullptr};
+
+    PyObject * poses_arg = nullptr;
+    PyObject * world_arg = nullptr;
+    PyObject * out = nullptr;
+
+    WorldObject * world = nullptr;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO|O", (char **)keywords,
+                &poses_arg, &world_arg, &out) ||
+            !get_world(world_arg, world)) {
+        return nullptr;
+    }
+
+    // An (N, 6) C-contiguous float64 array is read in place, as pose_t
+    // is six packed doubles; anything else is copied pose by pose
+    Py_buffer poses_view = {};
+    const simsens::pose_t * poses = nullptr;
+    vector<simsens::pose_t> copied;
+    Py_ssize_t count = 0;
+
+    if (PyObject_CheckBuffer(poses_arg) &&
+            PyObject_GetBuffer(poses_arg, &poses_view,
+                PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == 0) {
+
+        if (poses_view.ndim != 2 || poses_view.shape[1] != 6 ||
+                poses_view.itemsize != 8 ||
+                strcmp(plain_format(poses_view), "d")) {
+            PyBuffer_Release(&poses_view);
+            PyErr_SetString(PyExc_ValueError,
+                    "poses must be float64 with shape (N, 6)");
+            return nullptr;
+        }
+
+        poses = (const simsens::pose_t *)poses_view.buf;
+        count = poses_view.shape[0];
+    }
+
+    else {
+
+        PyErr_Clear();
+
+        auto sequence = PySequence_Fast(poses_arg,
+                "poses must be a sequence of poses");
+
+        if (!sequence) {
+            return nullptr;
+        }
+
+        count = PySequence_Fast_GET_SIZE(sequence);
+        copied.resize(count);
+
+        for (Py_ssize_t k=0; k<count; ++k) {
+            if (!parse_pose(PySequence_Fast_GET_ITEM(sequence, k),
+                        copied[k])) {
+                Py_DECREF(sequence);
+                return nullptr;
+            }
+        }
+
+        Py_DECREF(sequence);
+
+        poses = copied.data();
+    }
+
+    auto rangefinder = self->rangefinder;
+
+    Py_buffer view = {};
+    auto array = get_output(out, count, rangefinder->height,
+            rangefinder->width, view);
+
+    simsens::RangefinderOutput output;
+
+    if (!array || !make_output(view, count, rangefinder->height,
+                rangefinder->width, output) || !claim(self)) {
+        if (array) {
+            PyBuffer_Release(&view);
+            Py_DECREF(array);
+        }
+        if (poses_view.obj) {
+            PyBuffer_Release(&poses_view);
+        }
+        return nullptr;
+    }
+
+    world->readers++;
+
+    Py_BEGIN_ALLOW_THREADS
+    rangefinder->read_batch(poses, count, *world->world, output);
+    Py_END_ALLOW_THREADS
+
+    world->readers--;
+    self->busy = false;
+
+    PyBuffer_Release(&view);
+
+    if (poses_view.obj) {
+        PyBuffer_Release(&poses_view);
+    }
+
+    return array;
+}
+
+static PyObject * Rangefinder_get_width(RangefinderObject * self, void *)
+{
+    return PyLong_FromLong(self->rangefinder->width);
+}
+
+static PyObject * Rangefinder_get_height(RangefinderObject * self, void *)
+{
+    return PyLong_FromLong(self->rangefinder->height);
+}
+
+static PyObject * Rangefinder_get_min_range(RangefinderObject * self, void *)
+{
+    return PyFloat_FromDouble(self->rangefinder->min_distance_m);
+}
+
+static PyObject * Rangefinder_get_max_range(RangefinderObject * self, void *)
+{
+    return PyFloat_FromDouble(self->rangefinder->max_distance_m);
+}
+
+static PyMethodDef Rangefinder_methods[] = {
+    {"read", (PyCFunction)(void(*)(void))Rangefinder_read,
+        METH_VARARGS | METH_KEYWORDS,
+        "read(pose, world, out=None) -> (height, width) image of distances, "
+            "written into out if given (int types in mm, float types in m)"},
+    {"read_batch", (PyCFunction)(void(*)(void))Rangefinder_read_batch,
+        METH_VARARGS | METH_KEYWORDS,
+        "read_batch(poses, world, out=None) -> (N, height, width) images, "
+            "one per pose"},
+    {nullptr}
+};
+
+static PyGetSetDef Rangefinder_getset[] = {
+    {"width", (getter)Rangefinder_get_width, nullptr, nullptr, nullptr},
+    {"height", (getter)Rangefinder_get_height, nullptr, nullptr, nullptr},
+    {"min_range", (getter)Rangefinder_get_min_range, nullptr, nullptr,
+        nullptr},
+    {"max_range", (getter)Rangefinder_get_max_range, nullptr, nullptr,
+        nullptr},
+    {nullptr}
+};
+
+// Robot ----------------------------------------------------------------------
+
+static PyObject * Robot_new(PyTypeObject * type, PyObject *, PyObject *)
+{
+    auto self = (RobotObject *)type->tp_alloc(type, 0);
+
+    if (self) {
+        self->robot = new simsens::Robot();
+        self->rangefinders = nullptr;
+    }
+
+    return (PyObject *)self;
+}
+
+static int Robot_init(RobotObject * self, PyObject * args, PyObject * kwds)
+{
+    static const char * keywords[] = {"robot_file", nullptr};
+
+    const char * robot_file_name = nullptr;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s", (char **)keywords,
+                &robot_file_name) ||
+            !check_readable(robot_file_name)) {
+        return -1;
+    }
+
+    if (self->rangefinders) {
+        PyErr_SetString(PyExc_RuntimeError, "Robot is already initialized");
+        return -1;
+    }
+
+    simsens::RobotParser::parse(robot_file_name, *self->robot);
+
+    // Each sensor keeps its robot alive
+    self->rangefinders = PyDict_New();
+
+    if (!self->rangefinders) {
+        return -1;
+    }
+
+    for (auto entry : self->robot->rangefinders) {
+
+        auto sensor = (RangefinderObject *)RangefinderType.tp_alloc(
+                &RangefinderType, 0);
+
+        if (!sensor) {
+            return -1;
+        }
+
+        sensor->rangefinder = entry.second;
+        sensor->busy = false;
+        sensor->robot = (PyObject *)self;
+        Py_INCREF(self);
+
+        const auto status = PyDict_SetItemString(self->rangefinders,
+                entry.first.c_str(), (PyObject *)sensor);
+
+        Py_DECREF(sensor);
+
+        if (status < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int Robot_traverse(RobotObject * self, visitproc visit, void * arg)
+{
+    Py_VISIT(self->rangefinders);
+    return 0;
+}
+
+static int Robot_clear(RobotObject * self)
+{
+    Py_CLEAR(self->rangefinders);
+    return 0;
+}
+
+static void Robot_dealloc(RobotObject * self)
+{
+    PyObject_GC_UnTrack(self);
+
+    Robot_clear(self);
+
+    for (auto entry : self->robot->rangefinders) {
+        delete entry.second;
+    }
+
+    delete self->robot;
+
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static int Rangefinder_traverse(RangefinderObject * self, visitproc visit,
+        void * arg)
+{
+    Py_VISIT(self->robot);
+    return 0;
+}
+
+static int Rangefinder_clear(RangefinderObject * self)
+{
+    Py_CLEAR(self->robot);
+    return 0;
+}
+
+static PyObject * Robot_get_rangefinders(RobotObject * self, void *)
+{
+    if (!self->rangefinders) {
+        return PyDict_New();
+    }
+
+    return PyDictProxy_New(self->rangefinders);
+}
+
+static PyGetSetDef Robot_getset[] = {
+    {"rangefinders", (getter)Robot_get_rangefinders, nullptr,
+        "The robot's rangefinders by name", nullptr},
+    {nullptr}
+};
+
+// Module ---------------------------------------------------------------------
+
+static PyModuleDef engine_module = {
+    PyModuleDef_HEAD_INIT,
+    "simsensors.engine",
+    "World, Robot and Rangefinder from the C++ engine",
+    -1,
+    nullptr
+};
+
+PyMODINIT_FUNC PyInit_engine(void)
+{
+    WorldType.tp_name = "simsensors.engine.World";
+    WorldType.tp_doc = "World(world_file, robot_file='') parsed from a "
+        "Webots world file";
+    WorldType.tp_basicsize = sizeof(WorldObject);
+    WorldType.tp_flags = Py_TPFLAGS_DEFAULT;
+    WorldType.tp_new = World_new;
+    WorldType.tp_init = (initproc)World_init;
+    WorldType.tp_dealloc = (destructor)World_dealloc;
+    WorldType.tp_methods = World_methods;
+
+    RobotType.tp_name = "simsensors.engine.Robot";
+    RobotType.tp_doc = "Robot(robot_file) parsed from a Webots proto file";
+    RobotType.tp_basicsize = sizeof(RobotObject);
+    RobotType.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC;
+    RobotType.tp_new = Robot_new;
+    RobotType.tp_init = (initproc)Robot_init;
+    RobotType.tp_dealloc = (destructor)Robot_dealloc;
+    RobotType.tp_traverse = (traverseproc)Robot_traverse;
+    RobotType.tp_clear = (inquiry)Robot_clear;
+    RobotType.tp_getset = Robot_getset;
+
+    // Made only by Robot
+    RangefinderType.tp_name = "simsensors.engine.Rangefinder";
+    RangefinderType.tp_doc = "A robot's rangefinder";
+    RangefinderType.tp_basicsize = sizeof(RangefinderObject);
+    RangefinderType.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC;
+    RangefinderType.tp_dealloc = (destructor)Rangefinder_dealloc;
+    RangefinderType.tp_traverse = (traverseproc)Rangefinder_traverse;
+    RangefinderType.tp_clear = (inquiry)Rangefinder_clear;
+    RangefinderType.tp_methods = Rangefinder_methods;
+    RangefinderType.tp_getset = Rangefinder_getset;
+
+    if (PyType_Ready(&WorldType) < 0 || PyType_Ready(&RobotType) < 0 ||
+            PyType_Ready(&RangefinderType) < 0) {
+        return nullptr;
+    }
+
+    auto module = PyModule_Create(&engine_module);
+
+    if (!module) {
+        return nullptr;
+    }
+
+    PyObject * types[] = {(PyObject *)&WorldType, (PyObject *)&RobotType,
+        (PyObject *)&RangefinderType};
+    const char * names[] = {"World", "Robot", "Rangefinder"};
+
+    for (size_t k=0; k<3; ++k) {
+        Py_INCREF(types[k]);
+        if (PyModule_AddObject(module, names[k], types[k]) < 0) {
+            Py_DECREF(types[k]);
+            Py_DECREF(module);
+            return nullptr;
+        }
+    }
+
+    return module;
+}
@@ -0,0 +1,518 @@
+/*
+   Bounding-volume hierarchy for ray-versus-wall queries
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/math.hpp>
+#include <simsensors/src/obstacles/segments.hpp>
+#include <simsensors/src/simd.hpp>
+
+namespace simsens {
+
+    class Bvh {
+
+        public:
+
+            typedef struct {
+                double xmin;
+                double ymin;
+                double xmax;
+                double ymax;
+                uint32_t first; // first child, or first index for a leaf
+                uint32_t count; // number of walls; zero for an inner node
+            } node_t;
+
+            vector<node_t> nodes;
+
+            // Wall indices, ordered so that each leaf's walls are contiguous
+            vector<uint32_t> indices;
+
+            void build(const WallSegments & segments)
+            {
+                nodes.clear();
+                indices.resize(segments.count);
+
+                built_count = segments.count;
+                inserted = 0;
+
+                if (segments.count == 0) {
+                    link();
+                    return;
+                }
+
+                for (size_t k=0; k<segments.count; ++k) {
+                    indices[k] = k;
+                }
+
+                nodes.reserve(2 * segments.count);
+                nodes.push_back(node_t{});
+                split(segments, 0, 0, segments.count);
+
+                link();
+            }
+
+            // Whether the nodes form a tree no deeper than the traversal
+            // stacks allow, whose leaves hold each of wall_count walls
+            // exactly once, as a tree read from a file must before link()
+            bool valid(const size_t wall_count) const
+            {
+                if (nodes.empty()) {
+                    return indices.empty() || indices.size() == wall_count;
+                }
+
+                if (indices.size() != wall_count) {
+                    return false;
+                }
+
+                // Children follow their parents, so one pass in order sees
+                // every parent before its children
+                vector<int> depth(nodes.size(), 0);
+                vector<bool> held(wall_count, false);
+                size_t leaf_walls = 0;
+
+                depth[0] = 1;
+
+                for (size_t n=0; n<nodes.size(); ++n) {
+
+                    const auto & node = nodes[n];
+
+                    if (depth[n] == 0 || depth[n] > MAX_DEPTH / 2) {
+                        return false;
+                    }
+
+                    if (node.count > 0) {
+
+                        if ((uint64_t)node.first + node.count > indices.size()) {
+                            return false;
+                        }
+
+                        for (uint32_t c=node.first; c<node.first+node.count; ++c) {
+                            const auto k = indices[c];
+                            if (k >= wall_count || held[k]) {
+                                return false;
+                            }
+                            held[k] = true;
+                        }
+
+                        leaf_walls += node.count;
+                    }
+
+                    else {
+
+                        if (node.first <= n ||
+                                (uint64_t)node.first + 1 >= nodes.size() ||
+                                depth[node.first] || depth[node.first + 1]) {
+                            return false;
+                        }
+
+                        depth[node.first] = depth[n] + 1;
+                        depth[node.first + 1] = depth[n] + 1;
+                    }
+                }
+
+                return leaf_walls == wall_count;
+            }
+
+            // Finds each node's parent and each wall's leaf, which refits
+            // need; build() does this, and so must anything else that
+            // fills nodes and indices
+            void link()
+            {
+                parents.assign(nodes.size(), NONE);
+                leaves.assign(indices.size(), NONE);
+
+                for (uint32_t n=0; n<nodes.size(); ++n) {
+
+                    const auto & node = nodes[n];
+
+                    if (node.count > 0) {
+                        for (uint32_t c=node.first; c<node.first+node.count; ++c) {
+                            leaves[indices[c]] = n;
+                        }
+                    }
+                    else {
+                        parents[node.first] = n;
+                        parents[node.first + 1] = n;
+                    }
+                }
+            }
+
+            // Grows or shrinks the boxes holding a wall that has moved, from
+            // its leaf up to the root.  The tree keeps its shape, so it
+            // loosens as walls move far; unlike insert(), moves never
+            // trigger a rebuild, so call build() after large ones.
+            void refit(const WallSegments & segments, const size_t k)
+            {
+                auto n = leaves[k];
+
+                fit(segments, nodes[n]);
+
+                while (n != 0) {
+
+                    n = parents[n];
+
+                    auto & node = nodes[n];
+                    const auto & a = nodes[node.first];
+                    const auto & b = nodes[node.first + 1];
+
+                    const node_t fitted = {
+                        min(a.xmin, b.xmin), min(a.ymin, b.ymin),
+                        max(a.xmax, b.xmax), max(a.ymax, b.ymax),
+                        node.first, 0};
+
+                    if (fitted.xmin == node.xmin && fitted.ymin == node.ymin &&
+                            fitted.xmax == node.xmax && fitted.ymax == node.ymax) {
+                        break;
+                    }
+
+                    node = fitted;
+                }
+            }
+
+            // Adds a new wall, the one after the last, in a leaf of its own
+            // beside the leaf whose box it grows least, so that no other
+            // node moves.  Such leaves make a poorer tree than build(), so
+            // once the walls inserted since the last build number more
+            // than a quarter of those it saw, or the tree grows too deep,
+            // the next insert rebuilds it, at O(log N) amortized per insert.
+            void insert(const WallSegments & segments, const size_t k)
+            {
+                if (nodes.empty() ||
+                        REBUILD_FRACTION * ++inserted > built_count) {
+                    build(segments);
+                    return;
+                }
+
+                double x0=0, y0=0, x1=0, y1=0;
+                bounds(segments, k, x0, y0, x1, y1);
+
+                uint32_t n = 0;
+                int depth = 1;
+
+                while (nodes[n].count == 0) {
+                    const auto first = nodes[n].first;
+                    n = growth(nodes[first], x0, y0, x1, y1) <=
+                        growth(nodes[first + 1], x0, y0, x1, y1) ?
+                        first : first + 1;
+                    depth++;
+                }
+
+                if (depth >= MAX_DEPTH / 2) {
+                    build(segments);
+                    return;
+                }
+
+                const auto leaf = (uint32_t)nodes.size();
+
+                nodes.push_back(nodes[n]);
+                nodes.push_back(node_t {x0, y0, x1, y1,
+                        (uint32_t)indices.size(), 1});
+                nodes[n].count = 0;
+                nodes[n].first = leaf;
+
+                indices.push_back(k);
+
+                parents.resize(nodes.size(), n);
+
+                const auto & moved = nodes[leaf];
+
+                for (uint32_t c=moved.first; c<moved.first+moved.count; ++c) {
+                    leaves[indices[c]] = leaf;
+                }
+
+                leaves.resize(k + 1, NONE);
+                leaves[k] = leaf + 1;
+
+                refit(segments, k);
+            }
+
+            // Visits children nearest first, skipping any box that cannot
+            // hold a wall nearer than the best hit so far.  Gives the same
+            // result as nearest_segment_on_beam().  A finite bound seeds the
+            // search with a known hit on the wall passed in index.
+            template <typename T>
+            T nearest(
+                    const basic_beam_t<T> & beam,
+                    const BasicWallSegments<T> & segments,
+                    size_t & index,
+                    const T bound=INFINITY) const
+            {
+                T dist = bound;
+                index = bound < INFINITY ? index : segments.count;
+
+                if (nodes.empty()) {
+                    return dist;
+                }
+
+                const auto length = sqrt(beam.dx*beam.dx + beam.dy*beam.dy);
+
+                typedef struct {
+                    uint32_t node;
+                    double t;
+                } entry_t;
+
+                entry_t stack[MAX_DEPTH];
+                int top = 0;
+
+                double t0 = 0, t1 = 1;
+                if (!clip_beam_to_box(beam, nodes[0].xmin, nodes[0].ymin,
+                            nodes[0].xmax, nodes[0].ymax, t0, t1)) {
+                    return dist;
+                }
+
+                stack[top++] = {0, t0};
+
+                while (top > 0) {
+
+                    const auto entry = stack[--top];
+
+                    if (entry.t * length - segments.max_half_thickness -
+                            BOUND_TOLERANCE_M > dist) {
+                        continue;
+                    }
+
+                    const auto & node = nodes[entry.node];
+
+                    SIMSENS_COUNT(COUNTER_NODES_VISITED, 1);
+
+                    if (node.count > 0) {
+                        SIMSENS_COUNT(COUNTER_RAY_TESTS, node.count);
+                        for (uint32_t c=node.first; c<node.first+node.count; ++c) {
+                            const auto k = indices[c];
+                            reduce_nearest(
+                                    intersect_with_segment(beam, segments, k),
+                                    k, dist, index);
+                        }
+                        continue;
+                    }
+
+                    double ta0 = 0, ta1 = 1, tb0 = 0, tb1 = 1;
+                    const auto & a = nodes[node.first];
+                    const auto & b = nodes[node.first + 1];
+                    const auto hit_a = clip_beam_to_box(beam,
+                            a.xmin, a.ymin, a.xmax, a.ymax, ta0, ta1);
+                    const auto hit_b = clip_beam_to_box(beam,
+                            b.xmin, b.ymin, b.xmax, b.ymax, tb0, tb1);
+
+                    // Push the farther child first so the nearer pops first
+                    if (hit_a && hit_b && ta0 < tb0) {
+                        stack[top++] = {node.first + 1, tb0};
+                        stack[top++] = {node.first, ta0};
+                    }
+                    else {
+                        if (hit_a) {
+                            stack[top++] = {node.first, ta0};
+                        }
+                        if (hit_b) {
+                            stack[top++] = {node.first + 1, tb0};
+                        }
+                    }
+                }
+
+                return dist;
+            }
+
+            // Finds the wall with the smallest distance(k) to a query box
+            // (a point, or the bounds of a swept segment), visiting nodes
+            // nearest first and skipping any that cannot beat the best so far
+            template <typename F>
+            double nearest_to_box(
+                    const double qxmin, const double qymin,
+                    const double qxmax, const double qymax,
+                    const WallSegments & segments,
+                    F distance,
+                    size_t & index) const
+            {
+                double dist = INFINITY;
+                index = segments.count;
+
+                if (nodes.empty()) {
+                    return dist;
+                }
+
+                typedef struct {
+                    uint32_t node;
+                    double bound;
+                } entry_t;
+
+                entry_t stack[MAX_DEPTH];
+                int top = 0;
+
+                stack[top++] = {0, lower_bound(nodes[0],
+                        qxmin, qymin, qxmax, qymax, segments)};
+
+                while (top > 0) {
+
+                    const auto entry = stack[--top];
+
+                    if (entry.bound > dist) {
+                        continue;
+                    }
+
+                    const auto & node = nodes[entry.node];
+
+                    if (node.count > 0) {
+                        for (uint32_t c=node.first; c<node.first+node.count; ++c) {
+                            const auto k = indices[c];
+                            reduce_nearest(distance(k), k, dist, index);
+                        }
+                        continue;
+                    }
+
+                    const auto ba = lower_bound(nodes[node.first],
+                            qxmin, qymin, qxmax, qymax, segments);
+                    const auto bb = lower_bound(nodes[node.first + 1],
+                            qxmin, qymin, qxmax, qymax, segments);
+
+                    if (ba < bb) {
+                        stack[top++] = {node.first + 1, bb};
+                        stack[top++] = {node.first, ba};
+                    }
+                    else {
+                        stack[top++] = {node.first, ba};
+                        stack[top++] = {node.first + 1, bb};
+                    }
+                }
+
+                return dist;
+            }
+
+        private:
+
+            static constexpr uint32_t NONE = UINT32_MAX;
+
+            // Each node's parent, and each wall's leaf
+            vector<uint32_t> parents;
+            vector<uint32_t> leaves;
+
+            // Walls at the last build, and those inserted since
+            size_t built_count = 0;
+            size_t inserted = 0;
+
+            static constexpr uint32_t LEAF_SIZE = 4;
+            static constexpr size_t REBUILD_FRACTION = 4;
+            static constexpr int MAX_DEPTH = 128;
+            static constexpr double MARGIN_M = 1e-9;
+            static constexpr double BOUND_TOLERANCE_M = 1e-9;
+
+            // Walls extend up to their half-thickness beyond their boxes
+            static double lower_bound(const node_t & node,
+                    const double qxmin, const double qymin,
+                    const double qxmax, const double qymax,
+                    const WallSegments & segments)
+            {
+                return box_distance(node.xmin, node.ymin, node.xmax, node.ymax,
+                        qxmin, qymin, qxmax, qymax) -
+                    segments.max_half_thickness - BOUND_TOLERANCE_M;
+            }
+
+            static double center(const WallSegments & segments,
+                    const uint32_t k, const int axis)
+            {
+                return axis == 0 ?
+                    segments.x3[k] + segments.ex[k] / 2 :
+                    segments.y3[k] + segments.ey[k] / 2;
+            }
+
+            static void bounds(const WallSegments & segments, const size_t k,
+                    double & x0, double & y0, double & x1, double & y1)
+            {
+                const auto xa = segments.x3[k];
+                const auto ya = segments.y3[k];
+                const auto xb = xa + segments.ex[k];
+                const auto yb = ya + segments.ey[k];
+
+                x0 = min(xa, xb) - MARGIN_M;
+                y0 = min(ya, yb) - MARGIN_M;
+                x1 = max(xa, xb) + MARGIN_M;
+                y1 = max(ya, yb) + MARGIN_M;
+            }
+
+            // How much a node's box would grow in area to take a wall
+            static double growth(const node_t & node,
+                    const double x0, const double y0,
+                    const double x1, const double y1)
+            {
+                return (max(node.xmax, x1) - min(node.xmin, x0)) *
+                    (max(node.ymax, y1) - min(node.ymin, y0)) -
+                    (node.xmax - node.xmin) * (node.ymax - node.ymin);
+            }
+
+            void fit(const WallSegments & segments, node_t & node) const
+            {
+                node.xmin = INFINITY;
+                node.ymin = INFINITY;
+                node.xmax = -INFINITY;
+                node.ymax = -INFINITY;
+
+                for (uint32_t c=node.first; c<node.first+node.count; ++c) {
+                    double x0=0, y0=0, x1=0, y1=0;
+                    bounds(segments, indices[c], x0, y0, x1, y1);
+                    node.xmin = min(node.xmin, x0);
+                    node.ymin = min(node.ymin, y0);
+                    node.xmax = max(node.xmax, x1);
+                    node.ymax = max(node.ymax, y1);
+                }
+            }
+
+            // Median split along the longer side of the node's box
+            void split(const WallSegments & segments, const uint32_t node_index,
+                    const uint32_t first, const uint32_t count, const int depth=1)
+            {
+                nodes[node_index].first = first;
+                nodes[node_index].count = count;
+                fit(segments, nodes[node_index]);
+
+                if (count <= LEAF_SIZE || depth >= MAX_DEPTH / 2) {
+                    return;
+                }
+
+                const auto & node = nodes[node_index];
+                const int axis =
+                    node.xmax - node.xmin > node.ymax - node.ymin ? 0 : 1;
+
+                const auto half = count / 2;
+
+                nth_element(indices.begin() + first,
+                        indices.begin() + first + half,
+                        indices.begin() + first + count,
+                        [&segments, axis](const uint32_t a, const uint32_t b) {
+                        return center(segments, a, axis) <
+                        center(segments, b, axis);
+                        });
+
+                const uint32_t child = nodes.size();
+                nodes.push_back(node_t{});
+                nodes.push_back(node_t{});
+
+                nodes[node_index].first = child;
+                nodes[node_index].count = 0;
+
+                split(segments, child, first, half, depth + 1);
+                split(segments, child + 1, first + half, count - half, depth + 1);
+            }
+    };
+
+}
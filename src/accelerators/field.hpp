@@ -0,0 +1,614 @@
+/*
+   Signed distance field over the world's obstacles, for constant-time
+   clearance queries and sphere-traced beams
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/math.hpp>
+#include <simsensors/src/profiler.hpp>
+
+namespace simsens {
+
+    // Samples, at the center of each cell of a grid over the XY plane, the
+    // signed distance to the nearest obstacle footprint and which obstacle
+    // that is.  Which obstacles count depends on height, so there is one
+    // layer of samples for each of up to MAX_LAYERS bands of heights,
+    // split at the obstacles' bottoms and tops, plus one of every obstacle
+    // for tracing beams.  A band holds every obstacle at any of its
+    // heights, so with more bottoms and tops than bands, some of its
+    // samples are nearer than the obstacles at a given height.
+    //
+    // Every obstacle offers itself to the samples within EXACT_CELLS cells
+    // of it, so that a sample nearer than that to an obstacle is exact;
+    // sweeps fill in the rest, which are no nearer than that.  Either way,
+    // a sample less the distance to it bounds the distance from a point
+    // to the band's obstacles from below.
+    class DistanceField {
+
+        public:
+
+            // An obstacle's bounds in XY, and the heights zmin <= z < zmax
+            // at which it is an obstacle
+            typedef struct {
+                uint32_t index;
+                double xmin;
+                double ymin;
+                double xmax;
+                double ymax;
+                double zmin;
+                double zmax;
+            } footprint_t;
+
+            typedef struct {
+                vector<float> distance;
+                vector<uint32_t> nearest;
+            } layer_t;
+
+            static constexpr uint32_t NONE = UINT32_MAX;
+
+            DistanceField()
+            {
+                xmin = 0;
+                ymin = 0;
+                xmax = 0;
+                ymax = 0;
+                cell_size = 0;
+                nx = 0;
+                ny = 0;
+            }
+
+            // Samples the footprints at the given cell size, coarsened if
+            // need be to keep all the layers under MAX_CELLS samples.
+            // distance(index, x, y) gives the signed XY distance from a
+            // point to the obstacle with the given index.
+            template <typename D>
+            void build(const vector<footprint_t> & footprints,
+                    const double cell_size_m, D distance)
+            {
+                *this = DistanceField();
+
+                if (footprints.empty() || !(cell_size_m > 0)) {
+                    return;
+                }
+
+                cell_size = cell_size_m;
+
+                this->footprints = footprints;
+
+                // The set of obstacles changes only at their bottoms and
+                // tops; keep evenly spaced ones of those if there are more
+                // than the bands allow
+                for (const auto & f : footprints) {
+                    for (const auto z : {f.zmin, f.zmax}) {
+                        if (isfinite(z)) {
+                            breaks.push_back(z);
+                        }
+                    }
+                }
+
+                sort(breaks.begin(), breaks.end());
+                breaks.erase(unique(breaks.begin(), breaks.end()),
+                        breaks.end());
+
+                if (breaks.size() >= MAX_LAYERS) {
+                    vector<double> kept;
+                    for (size_t l=1; l<MAX_LAYERS; ++l) {
+                        kept.push_back(breaks[l * breaks.size() / MAX_LAYERS]);
+                    }
+                    breaks = kept;
+                }
+
+                layers.resize(breaks.size() + 1);
+
+                xmin = INFINITY;
+                ymin = INFINITY;
+                xmax = -INFINITY;
+                ymax = -INFINITY;
+
+                for (const auto & f : footprints) {
+                    xmin = min(xmin, f.xmin);
+                    ymin = min(ymin, f.ymin);
+                    xmax = max(xmax, f.xmax);
+                    ymax = max(ymax, f.ymax);
+                }
+
+                // A margin of cells, so that every obstacle lies inside
+                const auto margin = MARGIN_CELLS * cell_size;
+
+                while (cells_along(xmax - xmin + 2 * margin) *
+                        cells_along(ymax - ymin + 2 * margin) *
+                        (long)(layers.size() + 1) > MAX_CELLS) {
+                    cell_size *= 2;
+                }
+
+                xmin -= MARGIN_CELLS * cell_size;
+                ymin -= MARGIN_CELLS * cell_size;
+                xmax += MARGIN_CELLS * cell_size;
+                ymax += MARGIN_CELLS * cell_size;
+
+                nx = cells_along(xmax - xmin);
+                ny = cells_along(ymax - ymin);
+
+                xmax = xmin + nx * cell_size;
+                ymax = ymin + ny * cell_size;
+
+                vector<uint32_t> active;
+
+                for (size_t l=0; l<layers.size(); ++l) {
+
+                    active.clear();
+                    for (uint32_t k=0; k<footprints.size(); ++k) {
+                        if (in_band(footprints[k], l)) {
+                            active.push_back(k);
+                        }
+                    }
+
+                    fill(layers[l], active, distance);
+                }
+
+                active.clear();
+                for (uint32_t k=0; k<footprints.size(); ++k) {
+                    active.push_back(k);
+                }
+
+                fill(all, active, distance);
+            }
+
+            bool contains(const double x, const double y) const
+            {
+                return nx > 0 && x >= xmin && x <= xmax &&
+                    y >= ymin && y <= ymax;
+            }
+
+            // The samples for obstacles at the given height, or null if
+            // there are none there
+            const layer_t * layer_at(const double z) const
+            {
+                if (layers.empty()) {
+                    return nullptr;
+                }
+
+                const auto & layer = layers[upper_bound(breaks.begin(),
+                        breaks.end(), z) - breaks.begin()];
+
+                return layer.distance.empty() ? nullptr : &layer;
+            }
+
+            // Bilinear interpolation of the samples around a point inside
+            // the field, and of their gradient if asked
+            double distance(const layer_t & layer,
+                    const double x, const double y,
+                    double * gx=nullptr, double * gy=nullptr) const
+            {
+                int i0=0, i1=0, j0=0, j1=0;
+                double fx=0, fy=0;
+                surrounding(x, y, i0, i1, j0, j1, fx, fy);
+
+                const double a = layer.distance[j0 * nx + i0];
+                const double b = layer.distance[j0 * nx + i1];
+                const double c = layer.distance[j1 * nx + i0];
+                const double d = layer.distance[j1 * nx + i1];
+
+                if (gx) {
+                    *gx = i1 > i0 ?
+                        ((1 - fy) * (b - a) + fy * (d - c)) / cell_size : 0;
+                }
+
+                if (gy) {
+                    *gy = j1 > j0 ?
+                        ((1 - fx) * (c - a) + fx * (d - b)) / cell_size : 0;
+                }
+
+                return (1 - fy) * ((1 - fx) * a + fx * b) +
+                    fy * ((1 - fx) * c + fx * d);
+            }
+
+            // The obstacles nearest the sixteen samples around a point
+            // inside the field; the point's own nearest is almost always
+            // among them
+            void candidates(const layer_t & layer,
+                    const double x, const double y, uint32_t nearest[16]) const
+            {
+                int i0=0, i1=0, j0=0, j1=0;
+                double fx=0, fy=0;
+                surrounding(x, y, i0, i1, j0, j1, fx, fy);
+
+                for (int dj=0; dj<4; ++dj) {
+                    for (int di=0; di<4; ++di) {
+                        const auto i = max(0, min(i0 + di - 1, nx - 1));
+                        const auto j = max(0, min(j0 + dj - 1, ny - 1));
+                        nearest[dj * 4 + di] = layer.nearest[j * nx + i];
+                    }
+                }
+            }
+
+            // A lower bound on the distance from a point inside the field to
+            // the layer's obstacles, from the four samples around it.  Where
+            // the nearest of those is within EXACT_CELLS cells of an
+            // obstacle, the bound is within a cell's diagonal of the
+            // distance to that sample's obstacle, one of the candidates().
+            double lower_bound(const layer_t & layer,
+                    const double x, const double y) const
+            {
+                int i0=0, i1=0, j0=0, j1=0;
+                double fx=0, fy=0;
+                surrounding(x, y, i0, i1, j0, j1, fx, fy);
+
+                double bound = -INFINITY;
+
+                for (const auto j : {j0, j1}) {
+                    for (const auto i : {i0, i1}) {
+                        bound = max(bound, exact(layer, i, j) - hypot(
+                                    x - (xmin + (i + 0.5) * cell_size),
+                                    y - (ymin + (j + 0.5) * cell_size)));
+                    }
+                }
+
+                return bound;
+            }
+
+            double cell_diagonal() const
+            {
+                return sqrt(2.) * cell_size;
+            }
+
+            // Sphere-traces the beam through empty space, stepping each time
+            // by a lower bound on the distance to any obstacle, and returns
+            // true with t at the first point where an obstacle might be
+            // near; returns false if the beam can't reach one
+            template <typename T>
+            bool march(const basic_beam_t<T> & beam, double & t) const
+            {
+                double t0 = 0, t1 = 1;
+
+                if (all.distance.empty() || !clip_beam_to_box(beam,
+                            xmin, ymin, xmax, ymax, t0, t1)) {
+                    return false;
+                }
+
+                const auto length = sqrt(beam.dx*beam.dx + beam.dy*beam.dy);
+
+                for (t=t0; t<=t1; ) {
+
+                    SIMSENS_COUNT(COUNTER_NODES_VISITED, 1);
+
+                    const int i = clamp_cell(
+                            (beam.x1 + t * beam.dx - xmin) / cell_size, nx);
+                    const int j = clamp_cell(
+                            (beam.y1 + t * beam.dy - ymin) / cell_size, ny);
+
+                    // The point is within half a diagonal of the sample
+                    const auto clear = exact(all, i, j) -
+                        TRACE_MARGIN_CELLS * cell_size;
+
+                    if (clear < cell_size) {
+                        return true;
+                    }
+
+                    t += clear / length;
+                }
+
+                return false;
+            }
+
+            // Takes an obstacle out of the samples, in time proportional to
+            // the cells it was nearest and the obstacles near those
+            template <typename D>
+            void remove(const footprint_t & f, D distance)
+            {
+                for (size_t k=0; k<footprints.size(); ++k) {
+                    if (footprints[k].index == f.index) {
+                        footprints.erase(footprints.begin() + k);
+                        break;
+                    }
+                }
+
+                for (size_t l=0; l<layers.size(); ++l) {
+                    if (in_band(f, l) && !layers[l].distance.empty()) {
+                        forget(layers[l], l, f, distance);
+                    }
+                }
+
+                if (!all.distance.empty()) {
+                    forget(all, layers.size(), f, distance);
+                }
+            }
+
+        private:
+
+            static constexpr int MARGIN_CELLS = 2;
+            static constexpr long MAX_CELLS = 1 << 24;
+            static constexpr size_t MAX_LAYERS = 8;
+
+            // How far from an obstacle its samples are exact
+            static constexpr int EXACT_CELLS = 4;
+
+            // How far an exact sample can overstate the distance from a
+            // point in its cell: half a diagonal, rounded up to allow for
+            // storing samples as floats
+            static constexpr double TRACE_MARGIN_CELLS = 0.75;
+
+            // Forward-and-back sweeps of the grid when filling a layer
+            static constexpr int SWEEPS = 2;
+
+            double xmin = 0;
+            double ymin = 0;
+            double xmax = 0;
+            double ymax = 0;
+            double cell_size = 0;
+            int nx = 0;
+            int ny = 0;
+
+            // Height bands: band l is [breaks[l-1], breaks[l])
+            vector<double> breaks;
+            vector<layer_t> layers;
+
+            layer_t all;
+
+            // For refilling the samples an obstacle taken out leaves
+            vector<footprint_t> footprints;
+
+            long cells_along(const double extent) const
+            {
+                return max(1L, (long)ceil(extent / cell_size));
+            }
+
+            static int clamp_cell(const double pos, const int n)
+            {
+                return !(pos >= 0) ? 0 : pos >= n ? n - 1 : (int)pos;
+            }
+
+            // The four samples around a point, and its place between them
+            void surrounding(const double x, const double y,
+                    int & i0, int & i1, int & j0, int & j1,
+                    double & fx, double & fy) const
+            {
+                const auto u = (x - xmin) / cell_size - 0.5;
+                const auto v = (y - ymin) / cell_size - 0.5;
+
+                i0 = max(0, min((int)floor(u), nx - 2));
+                j0 = max(0, min((int)floor(v), ny - 2));
+                i1 = min(i0 + 1, nx - 1);
+                j1 = min(j0 + 1, ny - 1);
+
+                fx = max(0., min(1., u - i0));
+                fy = max(0., min(1., v - j0));
+            }
+
+            // Whether the obstacle is there at any height in band l
+            bool in_band(const footprint_t & f, const size_t l) const
+            {
+                const auto bottom = l > 0 ? breaks[l-1] : -INFINITY;
+                const auto top = l < breaks.size() ? breaks[l] : INFINITY;
+
+                return f.zmin < top && f.zmax > bottom;
+            }
+
+            // A sample, as a lower bound on the distance from its center:
+            // beyond EXACT_CELLS cells, the sample may be too far, but the
+            // obstacles are at least that far
+            double exact(const layer_t & layer, const int i, const int j) const
+            {
+                return min((double)layer.distance[j * nx + i],
+                        EXACT_CELLS * cell_size);
+            }
+
+            // Offers a cell an obstacle, returning true if it is nearer
+            // than the one the cell has
+            template <typename D>
+            bool offer(layer_t & layer, D distance,
+                    const int i, const int j, const uint32_t index) const
+            {
+                const auto cell = j * nx + i;
+
+                if (index == NONE || index == layer.nearest[cell]) {
+                    return false;
+                }
+
+                const auto d = distance(index,
+                        xmin + (i + 0.5) * cell_size,
+                        ymin + (j + 0.5) * cell_size);
+
+                if (d < layer.distance[cell]) {
+                    layer.distance[cell] = d;
+                    layer.nearest[cell] = index;
+                    return true;
+                }
+
+                return false;
+            }
+
+            // Calls visit(i, j) for every cell whose center is within the
+            // given number of cells of a footprint's bounds, and maybe a few
+            // more, but none outside the block [bi0, bi1] x [bj0, bj1]
+            template <typename F>
+            void for_each_cell_near(const footprint_t & f, const int cells,
+                    F visit, const int bi0=0, const int bj0=0,
+                    const int bi1=INT32_MAX, const int bj1=INT32_MAX) const
+            {
+                const int i0 = max(bi0,
+                        clamp_cell((f.xmin - xmin) / cell_size - cells, nx));
+                const int i1 = min(bi1,
+                        clamp_cell((f.xmax - xmin) / cell_size + cells, nx));
+                const int j0 = max(bj0,
+                        clamp_cell((f.ymin - ymin) / cell_size - cells, ny));
+                const int j1 = min(bj1,
+                        clamp_cell((f.ymax - ymin) / cell_size + cells, ny));
+
+                for (int j=j0; j<=j1; ++j) {
+                    for (int i=i0; i<=i1; ++i) {
+                        visit(i, j);
+                    }
+                }
+            }
+
+            // Offers the cells of a block every active footprint within
+            // EXACT_CELLS cells of them
+            template <typename D>
+            void seed(layer_t & layer, const vector<uint32_t> & active,
+                    D distance, const int i0=0, const int j0=0,
+                    const int i1=INT32_MAX, const int j1=INT32_MAX) const
+            {
+                for (const auto k : active) {
+                    for_each_cell_near(footprints[k], EXACT_CELLS,
+                            [&](const int i, const int j) {
+                            offer(layer, distance, i, j, footprints[k].index);
+                            }, i0, j0, i1, j1);
+                }
+            }
+
+            // Seeds the cells near each active footprint with exact
+            // distances, then sweeps the grid, so that every cell gets an
+            // obstacle nearest it or nearly
+            template <typename D>
+            void fill(layer_t & layer, const vector<uint32_t> & active,
+                    D distance) const
+            {
+                if (active.empty()) {
+                    return;
+                }
+
+                layer.distance.assign(nx * ny, INFINITY);
+                layer.nearest.assign(nx * ny, NONE);
+
+                seed(layer, active, distance);
+
+                sweep(layer, distance, 0, 0, nx - 1, ny - 1);
+            }
+
+            // Sweeps a block of cells forward and back, offering each cell
+            // its neighbors' nearest obstacles, including those of
+            // neighbors outside the block
+            template <typename D>
+            void sweep(layer_t & layer, D distance,
+                    const int i0, const int j0, const int i1, const int j1) const
+            {
+                auto from = [&](const int i, const int j,
+                        const int di, const int dj) {
+                    const auto ni = i + di;
+                    const auto nj = j + dj;
+                    if (ni >= 0 && ni < nx && nj >= 0 && nj < ny) {
+                        offer(layer, distance, i, j,
+                                layer.nearest[nj * nx + ni]);
+                    }
+                };
+
+                for (int pass=0; pass<SWEEPS; ++pass) {
+
+                    for (int j=j0; j<=j1; ++j) {
+                        for (int i=i0; i<=i1; ++i) {
+                            from(i, j, -1, 0);
+                            from(i, j, -1, -1);
+                            from(i, j, 0, -1);
+                            from(i, j, +1, -1);
+                        }
+                        for (int i=i1; i>=i0; --i) {
+                            from(i, j, +1, 0);
+                        }
+                    }
+
+                    for (int j=j1; j>=j0; --j) {
+                        for (int i=i1; i>=i0; --i) {
+                            from(i, j, +1, 0);
+                            from(i, j, +1, +1);
+                            from(i, j, 0, +1);
+                            from(i, j, -1, +1);
+                        }
+                        for (int i=i0; i<=i1; ++i) {
+                            from(i, j, -1, 0);
+                        }
+                    }
+                }
+            }
+
+            // Clears the cells an obstacle was nearest, found by flooding
+            // out from where it was, then refills them from the obstacles
+            // near them and from their neighbors.  The layer is band l's,
+            // or with l past the bands, the one of every obstacle.
+            template <typename D>
+            void forget(layer_t & layer, const size_t l, const footprint_t & f,
+                    D distance) const
+            {
+                vector<int> stack;
+
+                auto clear = [&](const int i, const int j) {
+                    const auto cell = j * nx + i;
+                    if (layer.nearest[cell] == f.index) {
+                        layer.distance[cell] = INFINITY;
+                        layer.nearest[cell] = NONE;
+                        stack.push_back(cell);
+                    }
+                };
+
+                for_each_cell_near(f, EXACT_CELLS, clear);
+
+                if (stack.empty()) {
+                    return;
+                }
+
+                int i0 = nx, j0 = ny, i1 = -1, j1 = -1;
+
+                while (!stack.empty()) {
+
+                    const auto i = stack.back() % nx;
+                    const auto j = stack.back() / nx;
+                    stack.pop_back();
+
+                    i0 = min(i0, i);
+                    j0 = min(j0, j);
+                    i1 = max(i1, i);
+                    j1 = max(j1, j);
+
+                    for (int dj=-1; dj<=1; ++dj) {
+                        for (int di=-1; di<=1; ++di) {
+                            const auto ni = i + di;
+                            const auto nj = j + dj;
+                            if (ni >= 0 && ni < nx && nj >= 0 && nj < ny) {
+                                clear(ni, nj);
+                            }
+                        }
+                    }
+                }
+
+                vector<uint32_t> active;
+                for (uint32_t k=0; k<footprints.size(); ++k) {
+                    if (l >= layers.size() || in_band(footprints[k], l)) {
+                        active.push_back(k);
+                    }
+                }
+
+                seed(layer, active, distance, i0, j0, i1, j1);
+
+                sweep(layer, distance, i0, j0, i1, j1);
+
+                // Nothing left to refill from
+                if (layer.nearest[j0 * nx + i0] == NONE) {
+                    layer.distance.clear();
+                    layer.nearest.clear();
+                }
+            }
+    };
+
+}
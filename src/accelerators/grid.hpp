@@ -0,0 +1,471 @@
+/*
+   Uniform-grid acceleration structure for ray-versus-wall queries
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/math.hpp>
+#include <simsensors/src/obstacles/segments.hpp>
+#include <simsensors/src/simd.hpp>
+
+namespace simsens {
+
+    class UniformGrid {
+
+        friend class WorldCache;
+
+        public:
+
+            UniformGrid()
+            {
+                xmin = 0;
+                ymin = 0;
+                cell_size = 0;
+                nx = 0;
+                ny = 0;
+            }
+
+            // Zero until built over some walls
+            double cell_size_m() const
+            {
+                return nx > 0 ? cell_size : 0;
+            }
+
+            // Whether the cell lists are consistent with each other and
+            // name only walls below wall_count, as a grid read from a file
+            // must be before it is traversed
+            bool valid(const size_t wall_count) const
+            {
+                if (nx == 0) {
+                    return true;
+                }
+
+                const auto cells = (uint64_t)nx * (uint64_t)ny;
+
+                if (nx < 0 || ny <= 0 || cells >= INT32_MAX ||
+                        !(cell_size > 0 && isfinite(cell_size)) ||
+                        !isfinite(xmin) || !isfinite(ymin) ||
+                        cell_start.size() != cells + 1 ||
+                        cell_start[0] != 0 ||
+                        cell_start.back() != cell_walls.size()) {
+                    return false;
+                }
+
+                for (size_t c=0; c<cells; ++c) {
+                    if (cell_start[c] > cell_start[c+1]) {
+                        return false;
+                    }
+                }
+
+                for (const auto k : cell_walls) {
+                    if (k != NONE && k >= wall_count) {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            // Builds the grid over the cached segments; a cell size of zero
+            // picks one from the average wall length
+            void build(const WallSegments & segments, const double cell_size_m=0)
+            {
+                cell_start.clear();
+                cell_walls.clear();
+                overflow.clear();
+
+                nx = 0;
+                ny = 0;
+
+                if (segments.count == 0) {
+                    return;
+                }
+
+                xmin = INFINITY;
+                ymin = INFINITY;
+                double xmax = -INFINITY;
+                double ymax = -INFINITY;
+                double total_length = 0;
+
+                for (size_t k=0; k<segments.count; ++k) {
+                    double x0=0, y0=0, x1=0, y1=0;
+                    bounds(segments, k, x0, y0, x1, y1);
+                    xmin = min(xmin, x0);
+                    ymin = min(ymin, y0);
+                    xmax = max(xmax, x1);
+                    ymax = max(ymax, y1);
+                    total_length += sqrt(
+                            sqr(segments.ex[k]) + sqr(segments.ey[k]));
+                }
+
+                xmin -= MARGIN_M;
+                ymin -= MARGIN_M;
+                xmax += MARGIN_M;
+                ymax += MARGIN_M;
+
+                cell_size = cell_size_m > 0 ? cell_size_m :
+                    max(total_length / segments.count, MIN_CELL_SIZE_M);
+
+                // Keep the cell count proportional to the wall count
+                while (cells_along(xmax - xmin) * cells_along(ymax - ymin) >
+                        (int)(4 * segments.count + 16)) {
+                    cell_size *= 2;
+                }
+
+                nx = cells_along(xmax - xmin);
+                ny = cells_along(ymax - ymin);
+
+                // Count walls per cell, then fill the cells in a second pass
+                cell_start.assign(nx * ny + 1, 0);
+
+                for (size_t k=0; k<segments.count; ++k) {
+                    rasterize(segments, k, [this](const int cell, const size_t) {
+                            cell_start[cell+1]++;
+                            });
+                }
+
+                for (int c=0; c<nx*ny; ++c) {
+                    cell_start[c+1] += cell_start[c];
+                }
+
+                cell_walls.resize(cell_start[nx*ny]);
+
+                vector<uint32_t> fill(cell_start.begin(), cell_start.end()-1);
+
+                for (size_t k=0; k<segments.count; ++k) {
+                    rasterize(segments, k,
+                            [this, &fill](const int cell, const size_t index) {
+                            cell_walls[fill[cell]++] = index;
+                            });
+                }
+            }
+
+            // Walks the cells along the beam front to back, stopping once no
+            // wall in a farther cell can beat the nearest hit so far.  Gives
+            // the same result as nearest_segment_on_beam().  A finite bound
+            // seeds the search with a known hit on the wall passed in index;
+            // a t_begin past zero skips a part of the beam known to be clear.
+            template <typename T>
+            T nearest(
+                    const basic_beam_t<T> & beam,
+                    const BasicWallSegments<T> & segments,
+                    size_t & index,
+                    const T bound=INFINITY,
+                    const double t_begin=0) const
+            {
+                T dist = bound;
+                index = bound < INFINITY ? index : segments.count;
+
+                double t0 = 0, t1 = 1;
+
+                if (nx == 0 || !clip_beam_to_box(beam, xmin, ymin,
+                            xmin + nx * cell_size, ymin + ny * cell_size,
+                            t0, t1) || (t0 = max(t0, t_begin)) > t1) {
+                    return dist;
+                }
+
+                const auto length = sqrt(beam.dx*beam.dx + beam.dy*beam.dy);
+
+                int i = clamp_cell((beam.x1 + t0 * beam.dx - xmin) / cell_size, nx);
+                int j = clamp_cell((beam.y1 + t0 * beam.dy - ymin) / cell_size, ny);
+
+                const int step_i = beam.dx > 0 ? +1 : -1;
+                const int step_j = beam.dy > 0 ? +1 : -1;
+
+                const auto delta_i = beam.dx == 0 ? INFINITY :
+                    cell_size / fabs(beam.dx);
+                const auto delta_j = beam.dy == 0 ? INFINITY :
+                    cell_size / fabs(beam.dy);
+
+                auto next_i = beam.dx == 0 ? INFINITY :
+                    (xmin + (i + (step_i > 0)) * cell_size - beam.x1) / beam.dx;
+                auto next_j = beam.dy == 0 ? INFINITY :
+                    (ymin + (j + (step_j > 0)) * cell_size - beam.y1) / beam.dy;
+
+                auto t_enter = t0;
+
+                while (true) {
+
+                    // Hits in this or later cells are at least this far away
+                    if (t_enter * length - segments.max_half_thickness -
+                            BOUND_TOLERANCE_M > dist) {
+                        break;
+                    }
+
+                    const auto cell = j * nx + i;
+
+                    SIMSENS_COUNT(COUNTER_NODES_VISITED, 1);
+
+                    for_each_wall(cell, [&](const uint32_t k) {
+                            SIMSENS_COUNT(COUNTER_RAY_TESTS, 1);
+                            reduce_nearest(
+                                    intersect_with_segment(beam, segments, k),
+                                    (size_t)k, dist, index);
+                            });
+
+                    if (next_i < next_j) {
+                        t_enter = next_i;
+                        next_i += delta_i;
+                        i += step_i;
+                    }
+                    else {
+                        t_enter = next_j;
+                        next_j += delta_j;
+                        j += step_j;
+                    }
+
+                    if (t_enter > t1 || i < 0 || i >= nx || j < 0 || j >= ny) {
+                        break;
+                    }
+                }
+
+                return dist;
+            }
+
+            // Finds the wall with the smallest distance(k) to a query box
+            // (a point, or the bounds of a swept segment), searching rings
+            // of cells outward until no farther ring can beat the best
+            template <typename F>
+            double nearest_to_box(
+                    const double qxmin, const double qymin,
+                    const double qxmax, const double qymax,
+                    const WallSegments & segments,
+                    F distance,
+                    size_t & index) const
+            {
+                double dist = INFINITY;
+                index = segments.count;
+
+                if (nx == 0) {
+                    return dist;
+                }
+
+                const int i0 = clamp_cell((qxmin - xmin) / cell_size, nx);
+                const int j0 = clamp_cell((qymin - ymin) / cell_size, ny);
+                const int i1 = clamp_cell((qxmax - xmin) / cell_size, nx);
+                const int j1 = clamp_cell((qymax - ymin) / cell_size, ny);
+
+                for (int r=0; ; ++r) {
+
+                    // Cells in ring r are at least r-1 cells from the query
+                    if ((r - 1) * cell_size - segments.max_half_thickness -
+                            BOUND_TOLERANCE_M > dist) {
+                        break;
+                    }
+
+                    const int ia = i0 - r, ib = i1 + r;
+                    const int ja = j0 - r, jb = j1 + r;
+
+                    if (ia < 0 && ja < 0 && ib >= nx && jb >= ny && r > 0) {
+                        break;
+                    }
+
+                    for (int j=max(ja, 0); j<=min(jb, ny-1); ++j) {
+
+                        const auto border_row = r == 0 || j == ja || j == jb;
+
+                        for (int i=max(ia, 0); i<=min(ib, nx-1); ++i) {
+
+                            // Visit only the ring's border cells
+                            if (!border_row && i != ia && i != ib) {
+                                i = ib - 1;
+                                continue;
+                            }
+
+                            for_each_wall(j * nx + i, [&](const uint32_t k) {
+                                    reduce_nearest(distance(k), (size_t)k,
+                                            dist, index);
+                                    });
+                        }
+                    }
+                }
+
+                return dist;
+            }
+
+            // Takes a wall out of the cells it lies in, before it moves or
+            // is removed
+            void remove(const WallSegments & segments, const size_t k)
+            {
+                if (nx == 0) {
+                    return;
+                }
+
+                rasterize(segments, k, [this](const int cell, const size_t index) {
+
+                        for (auto c=cell_start[cell]; c<cell_start[cell+1]; ++c) {
+                            if (cell_walls[c] == index) {
+                                cell_walls[c] = NONE;
+                            }
+                        }
+
+                        if (!overflow.empty()) {
+                            auto & extra = overflow[cell];
+                            extra.erase(remove_if(extra.begin(), extra.end(),
+                                        [index](const uint32_t k) {
+                                        return k == index; }), extra.end());
+                        }
+                        });
+            }
+
+            // Puts a wall that has moved, or is new, into the cells it now
+            // lies in, reusing slots freed by remove() before overflowing.
+            // Returns false if the wall lies outside the grid, which then
+            // has to be rebuilt.
+            bool insert(const WallSegments & segments, const size_t k)
+            {
+                double x0=0, y0=0, x1=0, y1=0;
+                bounds(segments, k, x0, y0, x1, y1);
+
+                if (nx == 0 || !(x0 >= xmin && y0 >= ymin &&
+                            x1 <= xmin + nx * cell_size &&
+                            y1 <= ymin + ny * cell_size)) {
+                    return false;
+                }
+
+                rasterize(segments, k, [this](const int cell, const size_t index) {
+
+                        for (auto c=cell_start[cell]; c<cell_start[cell+1]; ++c) {
+                            if (cell_walls[c] == NONE) {
+                                cell_walls[c] = index;
+                                return;
+                            }
+                        }
+
+                        if (overflow.empty()) {
+                            overflow.resize(nx * ny);
+                        }
+
+                        overflow[cell].push_back(index);
+                        });
+
+                return true;
+            }
+
+        private:
+
+            static constexpr uint32_t NONE = UINT32_MAX;
+
+            static constexpr double MARGIN_M = 1e-6;
+            static constexpr double MIN_CELL_SIZE_M = 0.01;
+            static constexpr double BOUND_TOLERANCE_M = 1e-9;
+
+            double xmin = 0;
+            double ymin = 0;
+            double cell_size = 0;
+            int nx = 0;
+            int ny = 0;
+
+            // Compressed cell lists: the walls in cell c are
+            // cell_walls[cell_start[c] .. cell_start[c+1])
+            vector<uint32_t> cell_start;
+            vector<uint32_t> cell_walls;
+
+            // Walls that moved into a cell with no free slot, per cell;
+            // empty until one does.  Slots left by walls that moved out
+            // hold NONE.
+            vector<vector<uint32_t>> overflow;
+
+            template <typename F>
+            void for_each_wall(const int cell, F visit) const
+            {
+                for (auto c=cell_start[cell]; c<cell_start[cell+1]; ++c) {
+                    if (cell_walls[c] != NONE) {
+                        visit(cell_walls[c]);
+                    }
+                }
+
+                if (!overflow.empty()) {
+                    for (const auto k : overflow[cell]) {
+                        visit(k);
+                    }
+                }
+            }
+
+            int cells_along(const double extent) const
+            {
+                return max(1, (int)ceil(extent / cell_size));
+            }
+
+            static int clamp_cell(const double pos, const int n)
+            {
+                return !(pos >= 0) ? 0 : pos >= n ? n - 1 : (int)pos;
+            }
+
+            static void bounds(const WallSegments & segments, const size_t k,
+                    double & x0, double & y0, double & x1, double & y1)
+            {
+                const auto xa = segments.x3[k];
+                const auto ya = segments.y3[k];
+                const auto xb = xa + segments.ex[k];
+                const auto yb = ya + segments.ey[k];
+
+                x0 = min(xa, xb);
+                y0 = min(ya, yb);
+                x1 = max(xa, xb);
+                y1 = max(ya, yb);
+            }
+
+            // Conservatively visits every cell the wall's centerline touches,
+            // one row of cells at a time
+            template <typename F>
+            void rasterize(const WallSegments & segments, const size_t k,
+                    F visit) const
+            {
+                double x0=0, y0=0, x1=0, y1=0;
+                bounds(segments, k, x0, y0, x1, y1);
+
+                const auto xa = segments.x3[k];
+                const auto ya = segments.y3[k];
+                const auto ex = segments.ex[k];
+                const auto ey = segments.ey[k];
+
+                const int j0 = clamp_cell((y0 - MARGIN_M - ymin) / cell_size, ny);
+                const int j1 = clamp_cell((y1 + MARGIN_M - ymin) / cell_size, ny);
+
+                for (int j=j0; j<=j1; ++j) {
+
+                    auto xlo = x0;
+                    auto xhi = x1;
+
+                    if (ey != 0) {
+                        const auto ylo = max(y0, ymin + j * cell_size);
+                        const auto yhi = min(y1, ymin + (j + 1) * cell_size);
+                        const auto xp = xa + ex * (ylo - ya) / ey;
+                        const auto xq = xa + ex * (yhi - ya) / ey;
+                        xlo = max(x0, min(xp, xq));
+                        xhi = min(x1, max(xp, xq));
+                    }
+
+                    const int i0 = clamp_cell((xlo - MARGIN_M - xmin) / cell_size, nx);
+                    const int i1 = clamp_cell((xhi + MARGIN_M - xmin) / cell_size, nx);
+
+                    for (int i=i0; i<=i1; ++i) {
+                        visit(j * nx + i, k);
+                    }
+                }
+            }
+    };
+
+}
@@ -0,0 +1,188 @@
+/*
+   Exact and swept collision queries against wall and obstacle boxes
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+
+#include <algorithm>
+using namespace std;
+
+#include <simsensors/src/obstacles/segments.hpp>
+
+namespace simsens {
+
+    // Each wall is treated as an oriented box in the XY plane: its
+    // centerline segment, thickened by its half-thickness on either side.
+    // Box obstacles use the same oriented-box queries.
+    class CollisionDetector {
+
+        public:
+
+            // Signed distance from (x,y) to the wall's box, negative inside
+            static double point_to_wall(
+                    const WallSegments & segments, const size_t k,
+                    const double x, const double y)
+            {
+                return point_to_oriented_box(segments.cx[k], segments.cy[k],
+                        segments.ux[k], segments.uy[k],
+                        segments.half_length[k], segments.half_thickness[k],
+                        x, y);
+            }
+
+            // Signed distance from the segment (x0,y0)-(x1,y1) to the wall's
+            // box: the closest the segment comes, or the deepest endpoint
+            // penetration (at most zero) if the segment crosses the box
+            static double segment_to_wall(
+                    const WallSegments & segments, const size_t k,
+                    const double x0, const double y0,
+                    const double x1, const double y1)
+            {
+                return segment_to_oriented_box(segments.cx[k], segments.cy[k],
+                        segments.ux[k], segments.uy[k],
+                        segments.half_length[k], segments.half_thickness[k],
+                        x0, y0, x1, y1);
+            }
+
+            // Signed distance from (x,y) to the box centered at (cx,cy)
+            // with half-length hl along the unit vector (ux,uy) and
+            // half-thickness ht across it
+            static double point_to_oriented_box(
+                    const double cx, const double cy,
+                    const double ux, const double uy,
+                    const double hl, const double ht,
+                    const double x, const double y)
+            {
+                double lx = 0, ly = 0;
+                to_local(cx, cy, ux, uy, x, y, lx, ly);
+
+                return point_to_box(lx, ly, hl, ht);
+            }
+
+            // Signed distance from a segment to the same box
+            static double segment_to_oriented_box(
+                    const double cx, const double cy,
+                    const double ux, const double uy,
+                    const double hl, const double ht,
+                    const double x0, const double y0,
+                    const double x1, const double y1)
+            {
+                double ax = 0, ay = 0, bx = 0, by = 0;
+                to_local(cx, cy, ux, uy, x0, y0, ax, ay);
+                to_local(cx, cy, ux, uy, x1, y1, bx, by);
+
+                const auto da = point_to_box(ax, ay, hl, ht);
+                const auto db = point_to_box(bx, by, hl, ht);
+
+                if (crosses_box(ax, ay, bx, by, hl, ht)) {
+                    return min(0., min(da, db));
+                }
+
+                // Otherwise the closest approach is at an endpoint of the
+                // segment or at a corner of the box
+                auto dist = min(da, db);
+
+                for (int sx=-1; sx<=1; sx+=2) {
+                    for (int sy=-1; sy<=1; sy+=2) {
+                        dist = min(dist, point_to_segment(
+                                    sx * hl, sy * ht, ax, ay, bx, by));
+                    }
+                }
+
+                return dist;
+            }
+
+            static double point_to_segment(const double px, const double py,
+                    const double ax, const double ay,
+                    const double bx, const double by)
+            {
+                const auto dx = bx - ax;
+                const auto dy = by - ay;
+                const auto len2 = dx*dx + dy*dy;
+
+                const auto t = len2 > 0 ?
+                    max(0., min(1., ((px - ax) * dx + (py - ay) * dy) / len2)) :
+                    0;
+
+                const auto ex = ax + t * dx - px;
+                const auto ey = ay + t * dy - py;
+
+                return sqrt(ex*ex + ey*ey);
+            }
+
+        private:
+
+            static void to_local(
+                    const double cx, const double cy,
+                    const double ux, const double uy,
+                    const double x, const double y,
+                    double & lx, double & ly)
+            {
+                const auto dx = x - cx;
+                const auto dy = y - cy;
+
+                lx = dx * ux + dy * uy;
+                ly = dy * ux - dx * uy;
+            }
+
+            // Signed distance to the box [-hl,hl] x [-ht,ht]
+            static double point_to_box(const double x, const double y,
+                    const double hl, const double ht)
+            {
+                const auto qx = fabs(x) - hl;
+                const auto qy = fabs(y) - ht;
+
+                const auto ox = max(qx, 0.);
+                const auto oy = max(qy, 0.);
+
+                return sqrt(ox*ox + oy*oy) + min(max(qx, qy), 0.);
+            }
+
+            // Liang-Barsky clip of the segment against the box
+            static bool crosses_box(
+                    const double ax, const double ay,
+                    const double bx, const double by,
+                    const double hl, const double ht)
+            {
+                double t0 = 0, t1 = 1;
+
+                const double p[4] = {-(bx - ax), bx - ax, -(by - ay), by - ay};
+                const double q[4] = {ax + hl, hl - ax, ay + ht, ht - ay};
+
+                for (int k=0; k<4; ++k) {
+                    if (p[k] == 0) {
+                        if (q[k] < 0) {
+                            return false;
+                        }
+                    }
+                    else {
+                        const auto t = q[k] / p[k];
+                        if (p[k] < 0) {
+                            t0 = max(t0, t);
+                        }
+                        else {
+                            t1 = min(t1, t);
+                        }
+                    }
+                }
+
+                return t0 <= t1;
+            }
+    };
+
+}
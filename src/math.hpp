@@ -22,11 +22,12 @@
 
 #include <simsensors/src/types.h>
 #include <simsensors/src/obstacles/wall.hpp>
+#include <simsensors/src/obstacles/segments.hpp>
 
 namespace simsens {
 
     // https://www.euclideanspace.com/maths/geometry/rotations/conversions/angleToEuler/index.htm
-    static void rotation_to_euler(const rotation_t & rotation, vec3_t & angles)
+    static inline void rotation_to_euler(const rotation_t & rotation, vec3_t & angles)
     {
         static constexpr double TOL = 2e-3;
 
@@ -67,101 +68,166 @@ namespace simsens {
         }
     }
 
-    // https://gist.github.com/kylemcdonald/6132fc1c29fd3767691442ba4bc84018
-    static bool line_segments_intersect(
-            const double x1, const double y1,
-            const double x2, const double y2,
-            const double x3, const double y3,
-            const double x4, const double y4,
-            double & px, double & py)
+    static inline double sqr(const double x)
     {
-        const auto denom = (y4 - y3) * (x2 - x1) - (x4 - x3) * (y2 - y1);
+        return x * x;
+    }
 
-        if (denom != 0) {
+    // Per-beam terms, computed once and shared by every wall test
+    template <typename T>
+    struct basic_beam_t {
+        T x1;
+        T y1;
+        T x2;
+        T y2;
+        T dx;
+        T dy;
+        T z;
+        T tan_elevation;
+    };
+
+    typedef basic_beam_t<double> beam_t;
+
+    // An angle's cosine and sine, so that it can be added to another
+    // without calling either again
+    typedef struct {
+        double c;
+        double s;
+    } direction_t;
+
+    // Level beam along the azimuth with the given cosine and sine,
+    // reaching the given distance in XY
+    static inline beam_t make_beam(
+            const vec3_t & robot_location,
+            const double cos_azimuth,
+            const double sin_azimuth,
+            const double length)
+    {
+        beam_t beam = {};
 
-            const auto ua = ((x4 - x3) * (y1 - y3) - (y4 - y3) * (x1 - x3)) / denom;
-            const auto ub = ((x2 - x1) * (y1 - y3) - (y2 - y1) * (x1 - x3)) / denom;
+        beam.x1 = robot_location.x;
+        beam.y1 = robot_location.y;
+        beam.x2 = robot_location.x + cos_azimuth * length;
+        beam.y2 = robot_location.y - sin_azimuth * length;
+        beam.dx = beam.x2 - beam.x1;
+        beam.dy = beam.y2 - beam.y1;
+        beam.z = robot_location.z;
 
-            // Check if intersection point lies within both line segments (0 <=
-            // ua <= 1 and 0 <= ub <= 1)
-            if (0 <= ua && ua <= 1 && 0 <= ub && ub <= 1) {
+        return beam;
+    }
+
+    // Rounds a beam to another scalar type
+    template <typename T>
+    static basic_beam_t<T> beam_cast(const beam_t & beam)
+    {
+        return basic_beam_t<T> {
+            (T)beam.x1, (T)beam.y1, (T)beam.x2, (T)beam.y2,
+            (T)beam.dx, (T)beam.dy, (T)beam.z, (T)beam.tan_elevation};
+    }
+
+    // Clips the beam's parameter range [t0,t1] to an axis-aligned box,
+    // returning false if the beam misses the box
+    template <typename T>
+    static bool clip_beam_to_box(
+            const basic_beam_t<T> & beam,
+            const double xmin, const double ymin,
+            const double xmax, const double ymax,
+            double & t0, double & t1)
+    {
+        // A beam with an undefined direction hits nothing
+        if (isnan(beam.dx) || isnan(beam.dy)) {
+            return false;
+        }
 
-                px = x1 + ua * (x2 - x1);
-                py = y1 + ua * (y2 - y1);
+        const double starts[2] = {beam.x1, beam.y1};
+        const double dirs[2] = {beam.dx, beam.dy};
+        const double mins[2] = {xmin, ymin};
+        const double maxs[2] = {xmax, ymax};
 
-                return true;
+        for (int k=0; k<2; ++k) {
+
+            if (dirs[k] == 0) {
+                if (starts[k] < mins[k] || starts[k] > maxs[k]) {
+                    return false;
+                }
+            }
+
+            else {
+                auto ta = (mins[k] - starts[k]) / dirs[k];
+                auto tb = (maxs[k] - starts[k]) / dirs[k];
+                if (ta > tb) {
+                    const auto tmp = ta;
+                    ta = tb;
+                    tb = tmp;
+                }
+                t0 = ta > t0 ? ta : t0;
+                t1 = tb < t1 ? tb : t1;
             }
         }
 
-        return false;
+        return t0 <= t1;
     }
 
-    static double sqr(const double x)
+    // Distance between two axis-aligned boxes, zero if they overlap
+    static inline double box_distance(
+            const double ax0, const double ay0,
+            const double ax1, const double ay1,
+            const double bx0, const double by0,
+            const double bx1, const double by1)
     {
-        return x * x;
+        const auto dx = max(0., max(bx0 - ax1, ax0 - bx1));
+        const auto dy = max(0., max(by0 - ay1, ay0 - by1));
+
+        return sqrt(dx*dx + dy*dy);
     }
 
-    static double intersect_with_wall(
-            const vec3_t robot_location,
-            const double azimuth_angle,
-            const double elevation_angle,
-            const Wall & wall,
+    // Distance along a precomputed beam to a cached wall segment, or
+    // INFINITY if the beam misses it or passes over it.  No trigonometry is
+    // done per wall; examples/kernels checks this against the original
+    // per-beam wall test.
+    template <typename T>
+    static T intersect_with_segment(
+            const basic_beam_t<T> & beam,
+            const BasicWallSegments<T> & segments,
+            const size_t index,
             vec3_t * intersection=nullptr)
     {
-        static constexpr double MAX_WORLD_DIM_M = 20; // arbitrary
-
-        // Calculate beam endpoints
-        const vec2_t beam_start_xy = {robot_location.x, robot_location.y};
-        const vec2_t beam_end_xy = {
-            robot_location.x + cos(azimuth_angle) * MAX_WORLD_DIM_M,
-            robot_location.y - sin(azimuth_angle) * MAX_WORLD_DIM_M,
-        };
-
-
-        // Get wall endpoints
-        const auto psi = wall.rotation.alpha; // rot.  always 0 0 1 alpha
-        const auto len = wall.size.y / 2;
-        const auto wall_dx = len * sin(psi);
-        const auto wall_dy = len * cos(psi);
-        const auto wall_tx = wall.translation.x;
-        const auto wall_ty = wall.translation.y;
-
-        // If beam ((x1,y1),(x2,y2)) intersects with with wall
-        // ((x3,y3),(x4,y4)) 
-        double px=0, py=0;
-        if (line_segments_intersect(
-                    beam_start_xy.x, beam_start_xy.y,
-                    beam_end_xy.x, beam_end_xy.y,
-                    wall_tx + wall_dx, wall_ty + wall_dy,
-                    wall_tx - wall_dx, wall_ty - wall_dy,
-                    px, py)) {
-
-            // Use intersection (px,py) to calculate XY distance to wall
-            const auto dx = beam_start_xy.x - px;
-            const auto dy = beam_start_xy.y - py;
-            const auto xydist = sqrt(dx*dx + dy*dy);
-
-            // Use XY distance, robot Z, and elevation angle to calculate Z
-            // offset of intersection on wall w.r.t. robot Z
-            const auto dz = -tan(elevation_angle) * xydist;
-
-            // Calculate XYZ distance by including Z offset and wall
-            // thickness
-            const auto xyzdist = sqrt(dx*dx + dy*dy + dz*dz)
-                - wall.size.x / 2;
-
-            // Calculate Z in world coordinates
-            const auto pz = robot_location.z + dz;
-
-            // If Z is below wall and XYZ distance is shorter than
-            // current, update current
-            if (pz < wall.size.z) {
-                if (intersection) {
-                    intersection->x = px;
-                    intersection->y = py;
-                    intersection->z = pz;
+        const auto x3 = segments.x3[index];
+        const auto y3 = segments.y3[index];
+        const auto ex = segments.ex[index];
+        const auto ey = segments.ey[index];
+
+        const auto denom = ey * beam.dx - ex * beam.dy;
+
+        if (denom != 0) {
+
+            const auto ua = (ex * (beam.y1 - y3) - ey * (beam.x1 - x3)) / denom;
+            const auto ub = (beam.dx * (beam.y1 - y3) - beam.dy * (beam.x1 - x3)) / denom;
+
+            if (0 <= ua && ua <= 1 && 0 <= ub && ub <= 1) {
+
+                const auto px = beam.x1 + ua * beam.dx;
+                const auto py = beam.y1 + ua * beam.dy;
+
+                const auto dx = beam.x1 - px;
+                const auto dy = beam.y1 - py;
+                const auto xydist = sqrt(dx*dx + dy*dy);
+
+                const auto dz = -beam.tan_elevation * xydist;
+
+                const auto xyzdist = sqrt(dx*dx + dy*dy + dz*dz)
+                    - segments.half_thickness[index];
+
+                const auto pz = beam.z + dz;
+
+                if (pz < segments.height[index]) {
+                    if (intersection) {
+                        intersection->x = px;
+                        intersection->y = py;
+                        intersection->z = pz;
+                    }
+                    return xyzdist;
                 }
-                return xyzdist;
             }
         }
 
@@ -0,0 +1,182 @@
+/*
+   Box obstacles, rotated about the vertical axis
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/collision.hpp>
+#include <simsensors/src/obstacles/primitives.hpp>
+
+namespace simsens {
+
+    // Every box in the world, each stored as its center, its local axes,
+    // and its half-sizes, so that a ray test needs no trigonometry.  As
+    // with walls, only rotation about the vertical axis is used, and the
+    // box's local y axis lies along a wall of the same rotation.
+    class Boxes {
+
+        public:
+
+            typedef struct {
+                double cx;
+                double cy;
+                double cz;
+                double xx;  // local x axis
+                double xy;
+                double yx;  // local y axis
+                double yy;
+                double hx;
+                double hy;
+                double hz;
+            } box_t;
+
+            vector<box_t> items;
+
+            // Webots boxes are centered on their translation
+            void add(const vec3_t & translation, const rotation_t & rotation,
+                    const vec3_t & size)
+            {
+                items.push_back(box_t {});
+                set(items.size() - 1, translation, rotation, size);
+            }
+
+            void set(const size_t k, const vec3_t & translation,
+                    const rotation_t & rotation, const vec3_t & size)
+            {
+                items[k].hx = size.x / 2;
+                items[k].hy = size.y / 2;
+                items[k].hz = size.z / 2;
+
+                move(k, translation, rotation);
+            }
+
+            // Places a box anew, keeping its size
+            void move(const size_t k, const vec3_t & translation,
+                    const rotation_t & rotation)
+            {
+                const auto psi = rotation.alpha;
+
+                auto & b = items[k];
+
+                b.cx = translation.x;
+                b.cy = translation.y;
+                b.cz = translation.z;
+                b.xx = cos(psi);
+                b.xy = -sin(psi);
+                b.yx = sin(psi);
+                b.yy = cos(psi);
+            }
+
+            // Empties a box in place, so that the others keep their indices
+            void remove(const size_t k)
+            {
+                items[k].hz = -INFINITY;
+            }
+
+            bool removed(const size_t k) const
+            {
+                return !(items[k].hz >= 0);
+            }
+
+            size_t size() const
+            {
+                return items.size();
+            }
+
+            // XY distance along the ray to where it enters the box, or
+            // INFINITY
+            double intersect(const ray_t & ray, const size_t k) const
+            {
+                const auto & b = items[k];
+
+                const auto ox = ray.x - b.cx;
+                const auto oy = ray.y - b.cy;
+
+                double s0 = 0;
+                double s1 = ray.length;
+
+                return clip_ray_to_slab(ox * b.xx + oy * b.xy,
+                        ray.ux * b.xx + ray.uy * b.xy, -b.hx, b.hx, s0, s1) &&
+                    clip_ray_to_slab(ox * b.yx + oy * b.yy,
+                            ray.ux * b.yx + ray.uy * b.yy, -b.hy, b.hy, s0, s1) &&
+                    clip_ray_to_slab(ray.z - b.cz, -ray.slope,
+                            -b.hz, b.hz, s0, s1) ?  s0 : INFINITY;
+            }
+
+            // Signed XY distance from a point to the box's footprint
+            double footprint_distance(const size_t k,
+                    const double x, const double y) const
+            {
+                const auto & b = items[k];
+
+                return CollisionDetector::point_to_oriented_box(b.cx, b.cy,
+                        b.yx, b.yy, b.hy, b.hx, x, y);
+            }
+
+            // Same, or INFINITY if the point is above or below the box
+            double clearance(const size_t k,
+                    const double x, const double y, const double z) const
+            {
+                const auto & b = items[k];
+
+                return fabs(z - b.cz) <= b.hz ?
+                    footprint_distance(k, x, y) : INFINITY;
+            }
+
+            // Same for the closest approach of a segment, over the part
+            // of it that lies within the box's height
+            double swept_clearance(const size_t k,
+                    const vec3_t & a, const vec3_t & b) const
+            {
+                const auto & box = items[k];
+
+                vec3_t p = {}, q = {};
+
+                return clip_segment_to_slab(a, b, box.cz - box.hz,
+                        box.cz + box.hz, p, q) ?
+                    CollisionDetector::segment_to_oriented_box(box.cx, box.cy,
+                            box.yx, box.yy, box.hy, box.hx,
+                            p.x, p.y, q.x, q.y) : INFINITY;
+            }
+
+            void dump() const
+            {
+                for (size_t k=0; k<items.size(); ++k) {
+
+                    if (removed(k)) {
+                        continue;
+                    }
+
+                    const auto & b = items[k];
+
+                    printf("Box: \n");
+                    printf("  center: x=%+3.3fm y=%+3.3fm z=%+3.3fm\n",
+                            b.cx, b.cy, b.cz);
+                    printf("  size: x=%3.3fm y=%3.3fm z=%3.3fm\n",
+                            2 * b.hx, 2 * b.hy, 2 * b.hz);
+                    printf("\n");
+                }
+            }
+    };
+
+}
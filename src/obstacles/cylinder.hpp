@@ -0,0 +1,167 @@
+/*
+   Upright cylinder obstacles, such as pillars
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/collision.hpp>
+#include <simsensors/src/obstacles/primitives.hpp>
+
+namespace simsens {
+
+    // Every cylinder in the world, with its axis vertical
+    class Cylinders {
+
+        public:
+
+            typedef struct {
+                double cx;
+                double cy;
+                double zmin;
+                double zmax;
+                double radius;
+            } cylinder_t;
+
+            vector<cylinder_t> items;
+
+            // Webots cylinders are centered on their translation
+            void add(const vec3_t & translation, const double radius,
+                    const double height)
+            {
+                items.push_back(cylinder_t {});
+                set(items.size() - 1, translation, radius, height);
+            }
+
+            void set(const size_t k, const vec3_t & translation,
+                    const double radius, const double height)
+            {
+                items[k] = cylinder_t {translation.x, translation.y,
+                        translation.z - height / 2, translation.z + height / 2,
+                        radius};
+            }
+
+            // Places a cylinder anew, keeping its size
+            void move(const size_t k, const vec3_t & translation)
+            {
+                auto & c = items[k];
+
+                set(k, translation, c.radius, c.zmax - c.zmin);
+            }
+
+            // Empties a cylinder in place, so that the others keep their
+            // indices
+            void remove(const size_t k)
+            {
+                items[k].zmin = INFINITY;
+                items[k].zmax = -INFINITY;
+            }
+
+            bool removed(const size_t k) const
+            {
+                return !(items[k].zmin <= items[k].zmax);
+            }
+
+            size_t size() const
+            {
+                return items.size();
+            }
+
+            // XY distance along the ray to where it enters the cylinder,
+            // through its side or a cap, or INFINITY
+            double intersect(const ray_t & ray, const size_t k) const
+            {
+                const auto & c = items[k];
+
+                const auto ox = ray.x - c.cx;
+                const auto oy = ray.y - c.cy;
+
+                // The ray's direction in XY is a unit vector
+                const auto b = ox * ray.ux + oy * ray.uy;
+                const auto disc = b * b - (ox * ox + oy * oy - c.radius * c.radius);
+
+                if (disc < 0) {
+                    return INFINITY;
+                }
+
+                const auto root = sqrt(disc);
+
+                double s0 = max(-b - root, 0.);
+                double s1 = min(-b + root, ray.length);
+
+                return s0 <= s1 && clip_ray_to_slab(ray.z, -ray.slope,
+                        c.zmin, c.zmax, s0, s1) ? s0 : INFINITY;
+            }
+
+            // Signed XY distance from a point to the cylinder
+            double footprint_distance(const size_t k,
+                    const double x, const double y) const
+            {
+                const auto & c = items[k];
+
+                return sqrt(sqr(x - c.cx) + sqr(y - c.cy)) - c.radius;
+            }
+
+            // Same, or INFINITY if the point is above or below it
+            double clearance(const size_t k,
+                    const double x, const double y, const double z) const
+            {
+                const auto & c = items[k];
+
+                return c.zmin <= z && z <= c.zmax ?
+                    footprint_distance(k, x, y) : INFINITY;
+            }
+
+            // Same for the closest approach of a segment, over the part
+            // of it that lies within the cylinder's height
+            double swept_clearance(const size_t k,
+                    const vec3_t & a, const vec3_t & b) const
+            {
+                const auto & c = items[k];
+
+                vec3_t p = {}, q = {};
+
+                return clip_segment_to_slab(a, b, c.zmin, c.zmax, p, q) ?
+                    CollisionDetector::point_to_segment(c.cx, c.cy,
+                            p.x, p.y, q.x, q.y) - c.radius : INFINITY;
+            }
+
+            void dump() const
+            {
+                for (size_t k=0; k<items.size(); ++k) {
+
+                    if (removed(k)) {
+                        continue;
+                    }
+
+                    const auto & c = items[k];
+
+                    printf("Cylinder: \n");
+                    printf("  center: x=%+3.3fm y=%+3.3fm\n", c.cx, c.cy);
+                    printf("  z: %+3.3fm to %+3.3fm\n", c.zmin, c.zmax);
+                    printf("  radius: %3.3fm\n", c.radius);
+                    printf("\n");
+                }
+            }
+    };
+
+}
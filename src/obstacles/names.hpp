@@ -0,0 +1,123 @@
+/*
+   Interned table of obstacle names
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+namespace simsens {
+
+    // Names are only needed for messages, so they are kept out of the
+    // geometry the ray loops read.  Each distinct name is stored once, as a
+    // null-terminated string in one character block, and is referred to by
+    // a small id.
+    class NameTable {
+
+        friend class WorldCache;
+
+        public:
+
+            // Returns the id of the name, adding it if it is new
+            uint32_t intern(const string_view name)
+            {
+                // A table loaded from a cache has no slots until the first
+                // name is added to it
+                if (2 * (offsets.size() + 1) > slots.size()) {
+                    rehash(max((size_t)64, 4 * (offsets.size() + 1)));
+                }
+
+                auto slot = find(name);
+
+                if (slots[slot] == EMPTY) {
+
+                    slots[slot] = (uint32_t)offsets.size();
+
+                    offsets.push_back(chars.size());
+                    chars.insert(chars.end(), name.begin(), name.end());
+                    chars.push_back(0);
+                }
+
+                return slots[slot];
+            }
+
+            const char * get(const uint32_t id) const
+            {
+                return id < offsets.size() ? &chars[offsets[id]] : "";
+            }
+
+            size_t size() const
+            {
+                return offsets.size();
+            }
+
+            void clear()
+            {
+                chars.clear();
+                offsets.clear();
+                slots.clear();
+            }
+
+        private:
+
+            static constexpr uint32_t EMPTY = UINT32_MAX;
+
+            vector<char> chars;
+
+            // Where each id's name starts in chars
+            vector<uint64_t> offsets;
+
+            // Open-addressed hash table of ids, kept at most half full, so
+            // that lookups need no allocation per name
+            vector<uint32_t> slots;
+
+            // The slot holding the name's id, or the empty slot where it
+            // belongs
+            size_t find(const string_view name) const
+            {
+                const auto mask = slots.size() - 1;
+
+                auto slot = hash<string_view>()(name) & mask;
+
+                while (slots[slot] != EMPTY && name != get(slots[slot])) {
+                    slot = (slot + 1) & mask;
+                }
+
+                return slot;
+            }
+
+            void rehash(const size_t min_slots)
+            {
+                size_t count = 1;
+                while (count < min_slots) {
+                    count *= 2;
+                }
+
+                slots.assign(count, EMPTY);
+
+                for (uint32_t id=0; id<offsets.size(); ++id) {
+                    slots[find(get(id))] = id;
+                }
+            }
+    };
+
+}
@@ -0,0 +1,75 @@
+/*
+   Infinite horizontal planes, such as floors
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/obstacles/primitives.hpp>
+
+namespace simsens {
+
+    // Every horizontal plane in the world, seen from either side.  Planes
+    // take no part in collision queries, since a robot resting on the
+    // floor hasn't collided with it.
+    class Planes {
+
+        public:
+
+            typedef struct {
+                double z;
+            } plane_t;
+
+            vector<plane_t> items;
+
+            void add(const double z)
+            {
+                items.push_back(plane_t {z});
+            }
+
+            size_t size() const
+            {
+                return items.size();
+            }
+
+            // XY distance along the ray to the plane, or INFINITY
+            double intersect(const ray_t & ray, const size_t k) const
+            {
+                if (ray.slope == 0) {
+                    return INFINITY;
+                }
+
+                const auto s = (ray.z - items[k].z) / ray.slope;
+
+                return s >= 0 && s <= ray.length ? s : INFINITY;
+            }
+
+            void dump() const
+            {
+                for (const auto & p : items) {
+                    printf("Plane: \n");
+                    printf("  z: %+3.3fm\n", p.z);
+                    printf("\n");
+                }
+            }
+    };
+
+}
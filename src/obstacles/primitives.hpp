@@ -0,0 +1,145 @@
+/*
+   Shared ray terms for obstacle primitives other than walls
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+
+#include <simsensors/src/math.hpp>
+#include <simsensors/src/profiler.hpp>
+#include <simsensors/src/simd.hpp>
+
+namespace simsens {
+
+    // A beam as a ray parameterized by its distance s in the XY plane: the
+    // point at s is (x + s ux, y + s uy, z - s slope).  Each primitive type
+    // returns the s at which a ray first meets one of its obstacles, and
+    // the world turns that into a distance along the beam.
+    typedef struct {
+        double x;
+        double y;
+        double z;
+        double ux;
+        double uy;
+        double slope;
+        double length;
+
+        // Distance along the beam per unit of s
+        double scale;
+    } ray_t;
+
+    // Returns false for a beam with no direction, which hits nothing
+    template <typename T>
+    static inline bool make_ray(const basic_beam_t<T> & beam, ray_t & ray)
+    {
+        const double dx = beam.dx;
+        const double dy = beam.dy;
+
+        ray.length = sqrt(dx*dx + dy*dy);
+
+        if (!(ray.length > 0)) {
+            return false;
+        }
+
+        ray.x = beam.x1;
+        ray.y = beam.y1;
+        ray.z = beam.z;
+        ray.ux = dx / ray.length;
+        ray.uy = dy / ray.length;
+        ray.slope = beam.tan_elevation;
+        ray.scale = sqrt(1 + ray.slope * ray.slope);
+
+        return true;
+    }
+
+    static inline vec3_t ray_point(const ray_t & ray, const double s)
+    {
+        return vec3_t {ray.x + s * ray.ux, ray.y + s * ray.uy,
+            ray.z - s * ray.slope};
+    }
+
+    // Narrows [s0,s1] to where o + s d lies within [lo,hi] on one axis
+    static inline bool clip_ray_to_slab(const double o, const double d,
+            const double lo, const double hi, double & s0, double & s1)
+    {
+        // An empty slab, as of a removed obstacle, lets nothing through
+        if (!(lo <= hi)) {
+            return false;
+        }
+
+        if (d == 0) {
+            return lo <= o && o <= hi;
+        }
+
+        auto sa = (lo - o) / d;
+        auto sb = (hi - o) / d;
+
+        if (sa > sb) {
+            const auto tmp = sa;
+            sa = sb;
+            sb = tmp;
+        }
+
+        s0 = sa > s0 ? sa : s0;
+        s1 = sb < s1 ? sb : s1;
+
+        return s0 <= s1;
+    }
+
+    // Narrows the segment from a to b to the part whose height lies
+    // within [lo,hi], returning its ends in p and q
+    static inline bool clip_segment_to_slab(const vec3_t & a,
+            const vec3_t & b, const double lo, const double hi,
+            vec3_t & p, vec3_t & q)
+    {
+        double t0 = 0;
+        double t1 = 1;
+
+        if (!clip_ray_to_slab(a.z, b.z - a.z, lo, hi, t0, t1)) {
+            return false;
+        }
+
+        p = vec3_t {a.x + t0 * (b.x - a.x), a.y + t0 * (b.y - a.y),
+            a.z + t0 * (b.z - a.z)};
+        q = vec3_t {a.x + t1 * (b.x - a.x), a.y + t1 * (b.y - a.y),
+            a.z + t1 * (b.z - a.z)};
+
+        return true;
+    }
+
+    // Nearest hit on the ray among one type's obstacles, numbered from
+    // first_index, reduced into dist and index.  Each type supplies its
+    // own intersect(), so the loop compiles to a tight, direct one.
+    template <typename S, typename T>
+    static inline void nearest_of(const S & shapes, const ray_t & ray,
+            const size_t first_index, T & dist, size_t & index)
+    {
+        SIMSENS_COUNT(COUNTER_RAY_TESTS, shapes.size());
+
+        for (size_t k=0; k<shapes.size(); ++k) {
+
+            const auto s = shapes.intersect(ray, k);
+
+            if (s < INFINITY) {
+                reduce_nearest((T)(s * ray.scale), first_index + k,
+                        dist, index);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,258 @@
+/*
+   Structure-of-arrays cache of wall segments for fast ray tests
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/obstacles/wall.hpp>
+
+namespace simsens {
+
+    // Walls seldom move, so we compute their endpoints once, instead of
+    // redoing the trigonometry for every wall on every beam.  The scalar
+    // type T is double, or float for sensors that read in single precision.
+    template <typename T>
+    class BasicWallSegments {
+
+        public:
+
+            // First endpoint (x3,y3) of each wall's centerline
+            vector<T> x3;
+            vector<T> y3;
+
+            // Direction (x4-x3, y4-y3) to the second endpoint, used in the
+            // denominator and numerators of the segment-intersection test
+            vector<T> ex;
+            vector<T> ey;
+
+            vector<T> half_thickness;
+            vector<T> height;
+
+            // Center, unit direction, and half-length of each wall, for
+            // distance queries against the wall's box
+            vector<T> cx;
+            vector<T> cy;
+            vector<T> ux;
+            vector<T> uy;
+            vector<T> half_length;
+
+            size_t count;
+
+            // Lets ray traversals bound the distance to walls not yet tested
+            T max_half_thickness;
+
+            BasicWallSegments()
+            {
+                count = 0;
+                max_half_thickness = 0;
+            }
+
+            void build(const vector<Wall> & walls)
+            {
+                clear();
+                reserve(walls.size());
+
+                for (const auto & wall : walls) {
+                    add(wall);
+                }
+            }
+
+            void add(const Wall & wall)
+            {
+                resize(count + 1);
+                set(count - 1, wall);
+            }
+
+            // Recomputes one wall's entry, for a wall that has moved
+            void set(const size_t k, const Wall & wall)
+            {
+                const auto psi = wall.rotation.alpha; // rot.  always 0 0 1 alpha
+                const auto len = wall.size.y / 2;
+                const auto wall_dx = len * sin(psi);
+                const auto wall_dy = len * cos(psi);
+                const auto wall_tx = wall.translation.x;
+                const auto wall_ty = wall.translation.y;
+
+                const auto x3_ = wall_tx + wall_dx;
+                const auto y3_ = wall_ty + wall_dy;
+                const auto x4_ = wall_tx - wall_dx;
+                const auto y4_ = wall_ty - wall_dy;
+
+                x3[k] = x3_;
+                y3[k] = y3_;
+                ex[k] = x4_ - x3_;
+                ey[k] = y4_ - y3_;
+
+                half_thickness[k] = wall.size.x / 2;
+                height[k] = wall.size.z;
+
+                const auto length = sqrt(
+                        (x4_ - x3_) * (x4_ - x3_) + (y4_ - y3_) * (y4_ - y3_));
+
+                cx[k] = (x3_ + x4_) / 2;
+                cy[k] = (y3_ + y4_) / 2;
+                ux[k] = length > 0 ? (x4_ - x3_) / length : 1;
+                uy[k] = length > 0 ? (y4_ - y3_) / length : 0;
+                half_length[k] = length / 2;
+
+                // Only ever grows, so it stays a bound as walls move
+                max_half_thickness =
+                    max(max_half_thickness, (T)(wall.size.x / 2));
+            }
+
+            // Copies another cache's entry exactly, so that subsets give
+            // bitwise the same results as the full cache
+            void append(const BasicWallSegments & from, const size_t k)
+            {
+                x3.push_back(from.x3[k]);
+                y3.push_back(from.y3[k]);
+                ex.push_back(from.ex[k]);
+                ey.push_back(from.ey[k]);
+                half_thickness.push_back(from.half_thickness[k]);
+                height.push_back(from.height[k]);
+                cx.push_back(from.cx[k]);
+                cy.push_back(from.cy[k]);
+                ux.push_back(from.ux[k]);
+                uy.push_back(from.uy[k]);
+                half_length.push_back(from.half_length[k]);
+
+                max_half_thickness =
+                    max(max_half_thickness, from.half_thickness[k]);
+
+                count++;
+            }
+
+            // Rounds another cache's entries to this cache's scalar type
+            template <typename U>
+            void assign(const BasicWallSegments<U> & from)
+            {
+                x3.assign(from.x3.begin(), from.x3.end());
+                y3.assign(from.y3.begin(), from.y3.end());
+                ex.assign(from.ex.begin(), from.ex.end());
+                ey.assign(from.ey.begin(), from.ey.end());
+                half_thickness.assign(from.half_thickness.begin(),
+                        from.half_thickness.end());
+                height.assign(from.height.begin(), from.height.end());
+                cx.assign(from.cx.begin(), from.cx.end());
+                cy.assign(from.cy.begin(), from.cy.end());
+                ux.assign(from.ux.begin(), from.ux.end());
+                uy.assign(from.uy.begin(), from.uy.end());
+                half_length.assign(from.half_length.begin(),
+                        from.half_length.end());
+
+                count = from.count;
+                max_half_thickness = from.max_half_thickness;
+            }
+
+            // Same for one entry, appending it if it is new
+            template <typename U>
+            void assign(const size_t k, const BasicWallSegments<U> & from)
+            {
+                if (k >= count) {
+                    resize(k + 1);
+                }
+
+                x3[k] = from.x3[k];
+                y3[k] = from.y3[k];
+                ex[k] = from.ex[k];
+                ey[k] = from.ey[k];
+                half_thickness[k] = from.half_thickness[k];
+                height[k] = from.height[k];
+                cx[k] = from.cx[k];
+                cy[k] = from.cy[k];
+                ux[k] = from.ux[k];
+                uy[k] = from.uy[k];
+                half_length[k] = from.half_length[k];
+
+                max_half_thickness = max(max_half_thickness,
+                        (T)from.max_half_thickness);
+            }
+
+            // Distance in the XY plane from a point to a wall's centerline
+            double centerline_distance(
+                    const size_t k, const double x, const double y) const
+            {
+                const auto dx = x - cx[k];
+                const auto dy = y - cy[k];
+
+                const auto along = max(
+                        fabs(dx * ux[k] + dy * uy[k]) - half_length[k], 0.);
+                const auto across = dy * ux[k] - dx * uy[k];
+
+                return sqrt(along * along + across * across);
+            }
+
+            void reserve(const size_t n)
+            {
+                x3.reserve(n);
+                y3.reserve(n);
+                ex.reserve(n);
+                ey.reserve(n);
+                half_thickness.reserve(n);
+                height.reserve(n);
+                cx.reserve(n);
+                cy.reserve(n);
+                ux.reserve(n);
+                uy.reserve(n);
+                half_length.reserve(n);
+            }
+
+            void resize(const size_t n)
+            {
+                x3.resize(n);
+                y3.resize(n);
+                ex.resize(n);
+                ey.resize(n);
+                half_thickness.resize(n);
+                height.resize(n);
+                cx.resize(n);
+                cy.resize(n);
+                ux.resize(n);
+                uy.resize(n);
+                half_length.resize(n);
+
+                count = n;
+            }
+
+            void clear()
+            {
+                x3.clear();
+                y3.clear();
+                ex.clear();
+                ey.clear();
+                half_thickness.clear();
+                height.clear();
+                cx.clear();
+                cy.clear();
+                ux.clear();
+                uy.clear();
+                half_length.clear();
+
+                count = 0;
+                max_half_thickness = 0;
+            }
+    };
+
+    typedef BasicWallSegments<double> WallSegments;
+
+}
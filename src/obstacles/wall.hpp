@@ -24,6 +24,8 @@
 
 namespace simsens {
 
+    // Just a wall's geometry; the world keeps walls by value in one array
+    // and their names in a separate table
     class Wall {
 
         public:
@@ -31,17 +33,19 @@ namespace simsens {
             vec3_t translation;
             rotation_t rotation;
             vec3_t size;
-            char name[100];
 
             Wall()
             {
+                translation = {};
+                size = {};
+
                 rotation.x = 0;
                 rotation.y = 0;
                 rotation.z = 1;
                 rotation.alpha = 0;
             }
 
-            void dump()
+            void dump() const
             {
                 printf("Wall: \n");
                 printf("  translation: x=%+3.3fm y=%+3.3fm z=%+3.3fm\n",
@@ -0,0 +1,301 @@
+/*
+   Versioned binary cache files, for loading parsed data without parsing
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/parsers/mapped_file.hpp>
+
+namespace simsens {
+
+    // A cache file is a header followed by arrays, each stored as its item
+    // count and item size and then its items, padded to eight bytes.  Items
+    // are stored in native layout, so a file is only read back on the kind
+    // of machine that wrote it; the header's magic number catches the rest.
+    class CacheFile {
+
+        public:
+
+            typedef struct {
+                char magic[8];
+                uint32_t version;
+                uint32_t kind;
+                uint64_t source_hash;
+            } header_t;
+
+            static constexpr uint32_t KIND_WORLD = 1;
+            static constexpr uint32_t KIND_ROBOT = 2;
+
+            // 64-bit hash of the data, seeded with a key naming everything
+            // besides the data that went into the cached result
+            static uint64_t keyed_hash(const string_view data,
+                    const string_view key)
+            {
+                auto hash = hash_bytes(SEED, key);
+                return hash_bytes(hash, data);
+            }
+
+            // Hash of a source file's contents, or zero if it can't be read
+            static uint64_t hash_file(const string file_name,
+                    const string_view key)
+            {
+                MappedFile file(file_name.c_str());
+
+                return file.is_open() ? keyed_hash(file.contents(), key) : 0;
+            }
+
+            class Writer {
+
+                public:
+
+                    Writer(const uint32_t kind, const uint32_t version,
+                            const uint64_t source_hash)
+                    {
+                        header_t header = {};
+                        memcpy(header.magic, MAGIC, sizeof(header.magic));
+                        header.version = version;
+                        header.kind = kind;
+                        header.source_hash = source_hash;
+
+                        put(header);
+                    }
+
+                    template <typename T>
+                    void put(const T & item)
+                    {
+                        put_array(&item, 1);
+                    }
+
+                    template <typename T>
+                    void put_array(const T * items, const uint64_t count)
+                    {
+                        const uint64_t item_size = sizeof(T);
+
+                        append(&count, sizeof(count));
+                        append(&item_size, sizeof(item_size));
+                        append(items, count * sizeof(T));
+
+                        buffer.resize((buffer.size() + 7) & ~(size_t)7, 0);
+                    }
+
+                    template <typename T>
+                    void put_vector(const vector<T> & items)
+                    {
+                        put_array(items.data(), items.size());
+                    }
+
+                    // Writes to a temporary file and renames it into place,
+                    // so readers never see a partly written cache
+                    bool save(const string file_name) const
+                    {
+                        const auto temp_name =
+                            file_name + ".tmp" + to_string(getpid());
+
+                        auto fp = fopen(temp_name.c_str(), "wb");
+
+                        if (!fp) {
+                            fprintf(stderr,
+                                    "Unable to open file %s for output\n",
+                                    temp_name.c_str());
+                            return false;
+                        }
+
+                        const auto wrote = fwrite(buffer.data(), 1,
+                                buffer.size(), fp) == buffer.size();
+
+                        if (fclose(fp) != 0 || !wrote ||
+                                rename(temp_name.c_str(), file_name.c_str())
+                                != 0) {
+                            fprintf(stderr, "Unable to write file %s\n",
+                                    file_name.c_str());
+                            remove(temp_name.c_str());
+                            return false;
+                        }
+
+                        return true;
+                    }
+
+                private:
+
+                    string buffer;
+
+                    void append(const void * data, const size_t size)
+                    {
+                        buffer.append((const char *)data, size);
+                    }
+            };
+
+            // Reads a mapped cache file in the order it was written.  Every
+            // get fails once any get has failed, so callers can check once
+            // at the end.
+            class Reader {
+
+                public:
+
+                    Reader(const MappedFile & file, const uint32_t kind,
+                            const uint32_t version, const uint64_t source_hash)
+                    {
+                        contents = file.contents();
+                        position = 0;
+                        ok = true;
+
+                        header_t header = {};
+
+                        ok = get(header) &&
+                            memcmp(header.magic, MAGIC,
+                                    sizeof(header.magic)) == 0 &&
+                            header.version == version &&
+                            header.kind == kind &&
+                            header.source_hash == source_hash;
+                    }
+
+                    bool valid() const
+                    {
+                        return ok;
+                    }
+
+                    // Lets callers reject contents that read correctly
+                    void fail()
+                    {
+                        ok = false;
+                    }
+
+                    template <typename T>
+                    bool get(T & item)
+                    {
+                        const T * items = nullptr;
+                        uint64_t count = 0;
+
+                        if (get_array(items, count) && count == 1) {
+                            memcpy(&item, items, sizeof(T));
+                            return true;
+                        }
+
+                        return ok = false;
+                    }
+
+                    // Points into the mapping, with no copying
+                    template <typename T>
+                    bool get_array(const T * & items, uint64_t & count)
+                    {
+                        uint64_t item_size = 0;
+
+                        if (!(ok && take(&count, sizeof(count)) &&
+                                    take(&item_size, sizeof(item_size)) &&
+                                    item_size == sizeof(T) &&
+                                    count <= (contents.size() - position) /
+                                    sizeof(T))) {
+                            return ok = false;
+                        }
+
+                        items = (const T *)(contents.data() + position);
+
+                        position += (count * sizeof(T) + 7) & ~(size_t)7;
+                        position = min(position, contents.size());
+
+                        return true;
+                    }
+
+                    template <typename T>
+                    bool get_vector(vector<T> & items)
+                    {
+                        const T * data = nullptr;
+                        uint64_t count = 0;
+
+                        if (!get_array(data, count)) {
+                            return false;
+                        }
+
+                        items.assign(data, data + count);
+
+                        return true;
+                    }
+
+                private:
+
+                    string_view contents;
+                    size_t position;
+                    bool ok;
+
+                    bool take(void * data, const size_t size)
+                    {
+                        if (contents.size() - position < size) {
+                            return false;
+                        }
+
+                        memcpy(data, contents.data() + position, size);
+                        position += size;
+
+                        return true;
+                    }
+            };
+
+        private:
+
+            static constexpr char MAGIC[8] = {
+                'S', 'I', 'M', 'S', 'E', 'N', 'S', '\n'};
+
+            static constexpr uint64_t SEED = 0x9e3779b97f4a7c15ull;
+            static constexpr uint64_t MULTIPLIER = 0xff51afd7ed558ccdull;
+
+            static uint64_t rotate(const uint64_t x, const int bits)
+            {
+                return (x << bits) | (x >> (64 - bits));
+            }
+
+            static uint64_t finish(uint64_t x)
+            {
+                x ^= x >> 33;
+                x *= MULTIPLIER;
+                x ^= x >> 33;
+                x *= 0xc4ceb9fe1a85ec53ull;
+                x ^= x >> 33;
+                return x;
+            }
+
+            // Eight bytes at a time, then the tail and the length
+            static uint64_t hash_bytes(uint64_t hash, const string_view bytes)
+            {
+                const auto data = bytes.data();
+                const auto size = bytes.size();
+
+                size_t k = 0;
+
+                for (; k + 8 <= size; k += 8) {
+                    uint64_t word = 0;
+                    memcpy(&word, data + k, 8);
+                    hash = rotate(hash ^ (word * MULTIPLIER), 29) * SEED;
+                }
+
+                uint64_t tail = 0;
+                memcpy(&tail, data + k, size - k);
+
+                return finish(hash ^ (tail * MULTIPLIER) ^ size);
+            }
+    };
+
+}
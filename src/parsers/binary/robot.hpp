@@ -0,0 +1,169 @@
+/*
+   Binary cache of a parsed robot's sensor specs
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/parsers/binary/cache.hpp>
+#include <simsensors/src/parsers/mapped_file.hpp>
+#include <simsensors/src/parsers/webots/robot.hpp>
+#include <simsensors/src/robot.hpp>
+#include <simsensors/src/sensors/rangefinder.hpp>
+
+namespace simsens {
+
+    class RobotCache {
+
+        public:
+
+            // Bump whenever the layout of anything cached changes
+            static constexpr uint32_t VERSION = 2;
+
+            // Loads the robot from the cache file if it was compiled from
+            // this robot file; otherwise parses the robot file and rewrites
+            // the cache.  Call on a freshly constructed robot.
+            static void parse(
+                    const string robot_file_name,
+                    const string cache_file_name,
+                    Robot & robot)
+            {
+                const auto hash = source_hash(robot_file_name);
+
+                if (hash != 0 && load(cache_file_name, hash, robot)) {
+                    return;
+                }
+
+                RobotParser::parse(robot_file_name, robot);
+
+                if (hash != 0) {
+                    save(cache_file_name, hash, robot);
+                }
+            }
+
+            static uint64_t source_hash(const string robot_file_name)
+            {
+                const auto key = "robot " + to_string(VERSION) + " " +
+                    to_string(sizeof(rangefinder_t));
+
+                return CacheFile::hash_file(robot_file_name, key);
+            }
+
+            static bool load(const string cache_file_name,
+                    const uint64_t source_hash, Robot & robot)
+            {
+                MappedFile file(cache_file_name.c_str());
+
+                if (!file.is_open()) {
+                    return false;
+                }
+
+                CacheFile::Reader reader(file, CacheFile::KIND_ROBOT,
+                        VERSION, source_hash);
+
+                const rangefinder_t * rangefinders = nullptr;
+                uint64_t count = 0;
+
+                if (!reader.get_array(rangefinders, count)) {
+                    return false;
+                }
+
+                for (uint64_t k=0; k<count; ++k) {
+
+                    rangefinder_t specs = {};
+                    memcpy(&specs, &rangefinders[k], sizeof(specs));
+
+                    auto rangefinder = new Rangefinder();
+
+                    rangefinder->width = specs.width;
+                    rangefinder->height = specs.height;
+                    rangefinder->min_distance_m = specs.min_distance_m;
+                    rangefinder->max_distance_m = specs.max_distance_m;
+                    rangefinder->field_of_view_radians =
+                        specs.field_of_view_radians;
+                    rangefinder->translation = specs.translation;
+                    rangefinder->rotation = specs.rotation;
+                    rangefinder->noise.sigma_m = specs.noise_sigma_m;
+                    rangefinder->noise.resolution_m = specs.resolution_m;
+                    memcpy(rangefinder->name, specs.name,
+                            sizeof(rangefinder->name) - 1);
+
+                    rangefinder->build_beam_angles();
+                    robot.rangefinders.insert({rangefinder->name, rangefinder});
+                }
+
+                return true;
+            }
+
+            static bool save(const string cache_file_name,
+                    const uint64_t source_hash, const Robot & robot)
+            {
+                CacheFile::Writer writer(CacheFile::KIND_ROBOT, VERSION,
+                        source_hash);
+
+                vector<rangefinder_t> rangefinders;
+
+                for (auto entry : robot.rangefinders) {
+
+                    const auto rangefinder = entry.second;
+
+                    rangefinder_t specs = {};
+
+                    specs.width = rangefinder->width;
+                    specs.height = rangefinder->height;
+                    specs.min_distance_m = rangefinder->min_distance_m;
+                    specs.max_distance_m = rangefinder->max_distance_m;
+                    specs.field_of_view_radians =
+                        rangefinder->field_of_view_radians;
+                    specs.translation = rangefinder->translation;
+                    specs.rotation = rangefinder->rotation;
+                    specs.noise_sigma_m = rangefinder->noise.sigma_m;
+                    specs.resolution_m = rangefinder->noise.resolution_m;
+                    memcpy(specs.name, rangefinder->name, sizeof(specs.name));
+
+                    rangefinders.push_back(specs);
+                }
+
+                writer.put_vector(rangefinders);
+
+                return writer.save(cache_file_name);
+            }
+
+        private:
+
+            // Everything the parser fills in; beam angles are rebuilt on load
+            typedef struct {
+                int32_t width;
+                int32_t height;
+                double min_distance_m;
+                double max_distance_m;
+                double field_of_view_radians;
+                vec3_t translation;
+                rotation_t rotation;
+                double noise_sigma_m;
+                double resolution_m;
+                char name[100];
+            } rangefinder_t;
+    };
+
+}
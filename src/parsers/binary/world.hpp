@@ -0,0 +1,270 @@
+/*
+   Binary cache of a parsed world, with its wall cache and spatial index
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+using namespace std;
+
+#include <simsensors/src/parsers/binary/cache.hpp>
+#include <simsensors/src/parsers/mapped_file.hpp>
+#include <simsensors/src/parsers/webots/world.hpp>
+#include <simsensors/src/world.hpp>
+
+namespace simsens {
+
+    class WorldCache {
+
+        public:
+
+            // Bump whenever the layout of anything cached changes
+            static constexpr uint32_t VERSION = 3;
+
+            // Loads the world from the cache file if it was compiled from
+            // this world file with the same robot and accelerator settings;
+            // otherwise parses the world file and rewrites the cache.  Call
+            // on a freshly constructed world, after use_accelerator().
+            static void parse(
+                    const string world_file_name,
+                    const string cache_file_name,
+                    World & world,
+                    const string robot_path="")
+            {
+                const auto hash = source_hash(world_file_name, world,
+                        robot_path);
+
+                if (hash != 0 && load(cache_file_name, hash, world)) {
+                    return;
+                }
+
+                WorldParser::parse(world_file_name, world, robot_path);
+
+                if (hash != 0) {
+                    save(cache_file_name, hash, world);
+                }
+            }
+
+            // Keyed by everything that changes the parsed result
+            static uint64_t source_hash(
+                    const string world_file_name,
+                    const World & world,
+                    const string robot_path="")
+            {
+                const auto key = "world " + to_string(VERSION) + " " +
+                    to_string(sizeof(Wall)) + " " +
+                    to_string(sizeof(Boxes::box_t)) + " " +
+                    to_string(sizeof(Cylinders::cylinder_t)) + " " +
+                    to_string(sizeof(Planes::plane_t)) + " " +
+                    to_string(world.accelerator) + " " +
+                    to_string(world.grid_cell_size_m) + " " + robot_path;
+
+                return CacheFile::hash_file(world_file_name, key);
+            }
+
+            static bool load(const string cache_file_name,
+                    const uint64_t source_hash, World & world)
+            {
+                MappedFile file(cache_file_name.c_str());
+
+                if (!file.is_open()) {
+                    return false;
+                }
+
+                CacheFile::Reader reader(file, CacheFile::KIND_WORLD,
+                        VERSION, source_hash);
+
+                vector<Wall> walls;
+                NameTable names;
+                vector<uint32_t> wall_names;
+                Boxes boxes;
+                Cylinders cylinders;
+                Planes planes;
+                vector<uint32_t> box_names;
+                vector<uint32_t> cylinder_names;
+                vector<uint32_t> plane_names;
+                pose_t pose = {};
+                bool y_inverted = false;
+                uint64_t segment_count = 0;
+                WallSegments segments;
+                accelerator_t accelerator = ACCELERATOR_NONE;
+                grid_t grid_params = {};
+                UniformGrid grid;
+                Bvh bvh;
+
+                reader.get_vector(walls);
+                reader.get_vector(names.chars);
+                reader.get_vector(names.offsets);
+                reader.get_vector(wall_names);
+                reader.get_vector(boxes.items);
+                reader.get_vector(box_names);
+                reader.get_vector(cylinders.items);
+                reader.get_vector(cylinder_names);
+                reader.get_vector(planes.items);
+                reader.get_vector(plane_names);
+                reader.get(pose);
+                reader.get(y_inverted);
+
+                reader.get(segment_count);
+                reader.get(segments.max_half_thickness);
+                for_each_column(segments, [&](vector<double> & column) {
+                        reader.get_vector(column);
+                        if (column.size() != segment_count) {
+                            reader.fail();
+                        }
+                        });
+
+                reader.get(accelerator);
+                reader.get(grid_params);
+                reader.get_vector(grid.cell_start);
+                reader.get_vector(grid.cell_walls);
+                reader.get_vector(bvh.nodes);
+                reader.get_vector(bvh.indices);
+
+                if (!reader.valid() || accelerator != world.accelerator ||
+                        segment_count != walls.size() ||
+                        wall_names.size() != walls.size() ||
+                        box_names.size() != boxes.size() ||
+                        cylinder_names.size() != cylinders.size() ||
+                        plane_names.size() != planes.size()) {
+                    return false;
+                }
+
+                // Every name must lie within the table
+                if (!names.chars.empty() && names.chars.back() != 0) {
+                    return false;
+                }
+                for (auto offset : names.offsets) {
+                    if (offset >= names.chars.size()) {
+                        return false;
+                    }
+                }
+                for (const auto ids : {&wall_names, &box_names,
+                        &cylinder_names, &plane_names}) {
+                    for (auto id : *ids) {
+                        if (id >= names.size()) {
+                            return false;
+                        }
+                    }
+                }
+
+                grid.xmin = grid_params.xmin;
+                grid.ymin = grid_params.ymin;
+                grid.cell_size = grid_params.cell_size;
+                grid.nx = grid_params.nx;
+                grid.ny = grid_params.ny;
+
+                // The spatial indexes must only lead to walls that exist
+                if (!grid.valid(segment_count) || !bvh.valid(segment_count)) {
+                    return false;
+                }
+
+                segments.count = segment_count;
+
+                world.walls = move(walls);
+                world.names = move(names);
+                world.wall_names = move(wall_names);
+                world.boxes = move(boxes);
+                world.cylinders = move(cylinders);
+                world.planes = move(planes);
+                world.box_names = move(box_names);
+                world.cylinder_names = move(cylinder_names);
+                world.plane_names = move(plane_names);
+                world.robotPose = pose;
+                world.y_inverted = y_inverted;
+                world.segments = move(segments);
+                world.float_segments.assign(world.segments);
+                world.grid = move(grid);
+                world.bvh = move(bvh);
+                world.bvh.link();
+
+                // Cheaper to rebuild than to store
+                world.build_distance_field();
+
+                return true;
+            }
+
+            static bool save(const string cache_file_name,
+                    const uint64_t source_hash, const World & world)
+            {
+                CacheFile::Writer writer(CacheFile::KIND_WORLD, VERSION,
+                        source_hash);
+
+                writer.put_vector(world.walls);
+                writer.put_vector(world.names.chars);
+                writer.put_vector(world.names.offsets);
+                writer.put_vector(world.wall_names);
+                writer.put_vector(world.boxes.items);
+                writer.put_vector(world.box_names);
+                writer.put_vector(world.cylinders.items);
+                writer.put_vector(world.cylinder_names);
+                writer.put_vector(world.planes.items);
+                writer.put_vector(world.plane_names);
+                writer.put(world.robotPose);
+                writer.put(world.y_inverted);
+
+                writer.put((uint64_t)world.segments.count);
+                writer.put(world.segments.max_half_thickness);
+                for_each_column(world.segments,
+                        [&writer](const vector<double> & column) {
+                        writer.put_vector(column);
+                        });
+
+                const grid_t grid = {world.grid.xmin, world.grid.ymin,
+                    world.grid.cell_size, world.grid.nx, world.grid.ny};
+
+                writer.put(world.accelerator);
+                writer.put(grid);
+                writer.put_vector(world.grid.cell_start);
+                writer.put_vector(world.grid.cell_walls);
+                writer.put_vector(world.bvh.nodes);
+                writer.put_vector(world.bvh.indices);
+
+                return writer.save(cache_file_name);
+            }
+
+        private:
+
+            typedef struct {
+                double xmin;
+                double ymin;
+                double cell_size;
+                int nx;
+                int ny;
+            } grid_t;
+
+            // Every per-wall array of the segment cache, in file order
+            template <typename S, typename F>
+            static void for_each_column(S & segments, F fn)
+            {
+                fn(segments.x3);
+                fn(segments.y3);
+                fn(segments.ex);
+                fn(segments.ey);
+                fn(segments.half_thickness);
+                fn(segments.height);
+                fn(segments.cx);
+                fn(segments.cy);
+                fn(segments.ux);
+                fn(segments.uy);
+                fn(segments.half_length);
+            }
+    };
+
+}
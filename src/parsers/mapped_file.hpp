@@ -0,0 +1,115 @@
+/*
+   Read-only memory-mapped file, for parsing without copying
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string_view>
+using namespace std;
+
+namespace simsens {
+
+    class MappedFile {
+
+        public:
+
+            MappedFile(const char * file_name)
+            {
+                data = nullptr;
+                size = 0;
+
+                const auto fd = open(file_name, O_RDONLY);
+
+                if (fd < 0) {
+                    return;
+                }
+
+                struct stat info = {};
+
+                if (fstat(fd, &info) == 0) {
+
+                    size = info.st_size;
+
+                    // An empty file can't be mapped, but is still open
+                    if (size == 0) {
+                        data = "";
+                    }
+
+                    else {
+                        auto addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE,
+                                fd, 0);
+                        data = addr == MAP_FAILED ? nullptr : (const char *)addr;
+                    }
+                }
+
+                close(fd);
+            }
+
+            ~MappedFile()
+            {
+                if (data && size > 0) {
+                    munmap((void *)data, size);
+                }
+            }
+
+            MappedFile(const MappedFile &) = delete;
+            MappedFile & operator=(const MappedFile &) = delete;
+
+            bool is_open() const
+            {
+                return data != nullptr;
+            }
+
+            string_view contents() const
+            {
+                return string_view(data ? data : "", size);
+            }
+
+            // Calls fn(line) for each line, without its newline
+            template <typename F>
+            void for_each_line(F fn) const
+            {
+                const auto text = contents();
+
+                size_t start = 0;
+
+                while (start < text.size()) {
+
+                    auto end = text.find('\n', start);
+
+                    if (end == string_view::npos) {
+                        end = text.size();
+                    }
+
+                    fn(text.substr(start, end - start));
+
+                    start = end + 1;
+                }
+            }
+
+        private:
+
+            const char * data;
+            size_t size;
+    };
+
+}
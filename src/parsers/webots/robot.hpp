@@ -20,7 +20,9 @@
 
 #include <stdio.h>
 
+#include <simsensors/src/parsers/mapped_file.hpp>
 #include <simsensors/src/parsers/webots/utils.hpp>
+#include <simsensors/src/profiler.hpp>
 #include <simsensors/src/sensors/rangefinder.hpp>
 #include <simsensors/src/math.hpp>
 #include <simsensors/src/robot.hpp>
@@ -33,15 +35,15 @@ namespace simsens {
 
             static void parse(const string robot_file_name, Robot & robot)
             {
-                ifstream file(robot_file_name);
+                SIMSENS_SCOPE(SCOPE_PARSE_ROBOT);
 
-                if (file.is_open()) {
+                MappedFile file(robot_file_name.c_str());
 
-                    string line;
+                if (file.is_open()) {
 
                     Rangefinder * rangefinder = nullptr;
 
-                    while (getline(file, line)) {
+                    file.for_each_line([&](const string_view line) {
 
                         if (ParserUtils::string_contains(line, "RangeFinder {")) {
                             rangefinder = new Rangefinder();
@@ -65,6 +67,15 @@ namespace simsens {
                                     line, "maxRange", 
                                     rangefinder->max_distance_m);
 
+                            // Webots gives the noise's standard deviation
+                            // relative to the maximum range; it is scaled
+                            // once the block is done
+                            ParserUtils::try_parse_double(line, "noise",
+                                    rangefinder->noise.sigma_m);
+
+                            ParserUtils::try_parse_double(line, "resolution",
+                                    rangefinder->noise.resolution_m);
+
                             ParserUtils::try_parse_vec3(line, "translation",
                                     rangefinder->translation);
 
@@ -76,11 +87,14 @@ namespace simsens {
 
                             if (ParserUtils::string_contains(line, "}") ||
                                     ParserUtils::string_contains(line, "children")) {
+                                rangefinder->noise.sigma_m *=
+                                    rangefinder->max_distance_m;
+                                rangefinder->build_beam_angles();
                                 robot.rangefinders.insert({rangefinder->name, rangefinder});
                                 rangefinder = nullptr;
                             }
                         }
-                    }
+                    });
                 }
 
                 else {
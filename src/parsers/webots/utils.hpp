@@ -18,13 +18,14 @@
 
 #pragma once
 
+#include <ctype.h>
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <charconv>
 #include <string>
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include <string_view>
 #include <vector>
 using namespace std;
 
@@ -32,101 +33,169 @@ using namespace std;
 
 namespace simsens {
 
+    // Parsing works on views of each line, so nothing is allocated per line
     class ParserUtils {
 
         public:
 
-            static bool try_parse_double(const string line, const string field_name,
-                    double & value) 
+            static bool try_parse_double(const string_view line,
+                    const string_view field_name, double & value) 
             {
                 if (string_contains(line, field_name)) {
-                    const auto toks = split_string(line, ' ');
-                    value = stof(toks[1]);
+                    parse_float(token(line, 1), value);
                     return true;
                 }
 
                 return false;
             }
 
-            static bool try_parse_int(const string line, const string field_name,
-                    int & value) 
+            static bool try_parse_int(const string_view line,
+                    const string_view field_name, int & value) 
             {
                 if (string_contains(line, field_name)) {
-                    const auto toks = split_string(line, ' ');
-                    value = stoi(toks[1]);
+                    parse_int(token(line, 1), value);
                     return true;
                 }
 
                 return false;
             }
 
-            static bool try_parse_vec3(const string line, const string field_name,
-                    vec3_t & vec) 
+            static bool try_parse_vec3(const string_view line,
+                    const string_view field_name, vec3_t & vec) 
             {
                 if (string_contains(line, field_name)) {
-                    const auto toks = split_string(line, ' ');
-                    vec.x = stof(toks[1]);
-                    vec.y = stof(toks[2]);
-                    vec.z = stof(toks[3]);
+                    parse_float(token(line, 1), vec.x);
+                    parse_float(token(line, 2), vec.y);
+                    parse_float(token(line, 3), vec.z);
                     return true;
                 }
 
                 return false;
             }
 
-            static bool try_parse_rotation(const string line, const string field_name,
-                    rotation_t & rot) 
+            static bool try_parse_rotation(const string_view line,
+                    const string_view field_name, rotation_t & rot) 
             {
                 if (string_contains(line, field_name)) {
-                    const auto toks = split_string(line, ' ');
-                    rot.x = stof(toks[1]);
-                    rot.y = stof(toks[2]);
-                    rot.z = stof(toks[3]);
-                    rot.alpha = stof(toks[4]);
+                    parse_float(token(line, 1), rot.x);
+                    parse_float(token(line, 2), rot.y);
+                    parse_float(token(line, 3), rot.z);
+                    parse_float(token(line, 4), rot.alpha);
                     return true;
                 }
 
                 return false;
             }
 
-            static bool try_parse_name(const string line, char * object_name)
+            static bool try_parse_name(const string_view line,
+                    char * object_name, const size_t max_length=100)
             {
                 if (string_contains(line, "name")) {
-                    const auto toks = split_string(line, ' ');
-                    const char * tok = toks[1].c_str();
-                    strncpy(object_name, &tok[1], strlen(tok)-2); // remove quotes
+                    const auto tok = token(line, 1);
+                    if (tok.size() >= 2) {
+                        // remove quotes
+                        const auto len = min(tok.size() - 2, max_length - 1);
+                        memcpy(object_name, tok.data() + 1, len);
+                        object_name[len] = 0;
+                    }
                     return true;
                 }
 
                 return false;
             }
 
-            static string strip_quotes(const string str)
+            // Type of the node a line opens, as in "Floor {" or
+            // "DEF name SolidBox {", or an empty view if it opens none
+            static string_view node_type(const string_view line)
+            {
+                const auto first = token(line, 0);
+                const auto type = first == "DEF" ? token(line, 2) : first;
+                const auto brace = token(line, first == "DEF" ? 3 : 1);
+
+                return brace == "{" ? type : string_view();
+            }
+
+            static bool string_ends_with(
+                    const string_view str, const string_view suffix)
             {
-                return str.substr(1, str.length()-2);
+                return str.size() >= suffix.size() &&
+                    str.substr(str.size() - suffix.size()) == suffix;
             }
 
             static bool string_contains(
-                    const string str, const string substr) 
+                    const string_view str, const string_view substr) 
             {
-                return str.find(substr) < str.length();
+                return str.find(substr) != string_view::npos;
             }
 
-            static vector<string> split_string(
-                    const string& s, const char delimiter=' ')
+            // Returns the index'th space-separated token, or an empty view
+            static string_view token(const string_view line, size_t index)
             {
-                vector<string> tokens;
-                string token;
-                // Create a stringstream object initialized with the input string
-                stringstream ss(s); 
-
-                // Use getline to extract tokens from the stream, using the delimiter
-                while (getline(ss, token, delimiter)) { 
-                    if (token.length() > 0) {
-                        tokens.push_back(token);
+                size_t pos = 0;
+
+                while (true) {
+
+                    while (pos < line.size() && line[pos] == ' ') {
+                        pos++;
+                    }
+
+                    if (pos == line.size()) {
+                        return string_view();
                     }
+
+                    const auto end = min(line.find(' ', pos), line.size());
+
+                    if (index == 0) {
+                        return line.substr(pos, end - pos);
+                    }
+
+                    index--;
+                    pos = end;
                 }
-                return tokens;
+            }
+
+            // Parses like stof(), whose single precision we keep so that
+            // values come out exactly as they always have
+            static bool parse_float(string_view tok, double & value)
+            {
+                tok = skip_sign(tok);
+
+                float f = 0;
+                const auto result =
+                    from_chars(tok.data(), tok.data() + tok.size(), f);
+
+                if (result.ec == errc()) {
+                    value = f;
+                    return true;
+                }
+
+                return false;
+            }
+
+            static bool parse_int(string_view tok, int & value)
+            {
+                tok = skip_sign(tok);
+
+                const auto result =
+                    from_chars(tok.data(), tok.data() + tok.size(), value);
+
+                return result.ec == errc();
+            }
+
+        private:
+
+            // from_chars() takes neither leading whitespace nor a plus sign
+            static string_view skip_sign(string_view tok)
+            {
+                while (!tok.empty() && isspace((unsigned char)tok[0])) {
+                    tok.remove_prefix(1);
+                }
+
+                if (!tok.empty() && tok[0] == '+') {
+                    tok.remove_prefix(1);
+                }
+
+                return tok;
             }
     };
 }
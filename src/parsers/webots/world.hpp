@@ -21,7 +21,9 @@
 #include <stdio.h>
 
 #include <simsensors/src/math.hpp>
+#include <simsensors/src/parsers/mapped_file.hpp>
 #include <simsensors/src/parsers/webots/utils.hpp>
+#include <simsensors/src/profiler.hpp>
 #include <simsensors/src/obstacles/wall.hpp>
 #include <simsensors/src/world.hpp>
 
@@ -36,40 +38,71 @@ namespace simsens {
                     World & world,
                     const string robot_path="")
             {
-                ifstream file(world_file_name);
+                SIMSENS_SCOPE(SCOPE_PARSE_WORLD);
+
+                MappedFile file(world_file_name.c_str());
 
                 if (file.is_open()) {
 
-                    string line;
+                    Wall wall;
+                    char name[100] = {};
+                    bool in_wall = false;
 
-                    Wall * _wall = nullptr;
+                    primitive_t primitive = {};
+                    auto in_primitive = PRIMITIVE_NONE;
 
                     bool in_robot = false;
 
                     world.y_inverted = true;
 
-                    while (getline(file, line)) {
+                    // The robot's name is its file name without directory or
+                    // extension
+                    const string_view path = robot_path;
+                    const auto slash_pos = path.rfind('/');
+                    const auto dot_pos = path.rfind('.');
+                    const auto robot_name =
+                        path.substr(slash_pos+1, dot_pos-slash_pos-1);
+
+                    file.for_each_line([&](const string_view line) {
 
                         if (ParserUtils::string_contains(line, "Wall {")) {
-                            _wall = new Wall();
+                            wall = Wall();
+                            name[0] = 0;
+                            in_wall = true;
                         }
 
-                        if (_wall) {
+                        if (in_wall) {
 
-                            parseWall(line, _wall);
+                            parseWall(line, wall, name);
 
                             if (endOfBlock(line)) {
 
-                                world.walls.push_back(_wall);
-                                _wall = nullptr;
+                                world.add_wall(wall, name);
+                                in_wall = false;
+                            }
+                        }
+
+                        if (in_primitive == PRIMITIVE_NONE) {
+                            in_primitive = primitiveType(line);
+                            if (in_primitive != PRIMITIVE_NONE) {
+                                primitive = primitive_t {};
+                                name[0] = 0;
                             }
                         }
 
-                        if (robot_path.size() > 0) {
-                            size_t slash_pos = robot_path.rfind('/');
-                            size_t dot_pos = robot_path.rfind('.');
-                            const auto robot_name = robot_path.substr(slash_pos+1, dot_pos-slash_pos-1);
-                            if( ParserUtils::string_contains(line, robot_name.c_str()) &&
+                        if (in_primitive != PRIMITIVE_NONE) {
+
+                            parsePrimitive(line, primitive, name);
+
+                            if (endOfBlock(line)) {
+                                addPrimitive(in_primitive, primitive, name,
+                                        world);
+                                in_primitive = PRIMITIVE_NONE;
+                            }
+                        }
+
+                        if (path.size() > 0) {
+                            if( ParserUtils::string_contains(line, robot_name) &&
                                     ParserUtils::string_contains(line, "{")) {
                                 in_robot = true;
                             }
@@ -84,7 +117,9 @@ namespace simsens {
                             }
 
                         }
-                    }
+                    });
+
+                    world.build_segment_cache();
                 }
 
                 else {
@@ -95,26 +130,96 @@ namespace simsens {
 
         private:
 
-            static bool endOfBlock(const string line) {
+            typedef enum {
+                PRIMITIVE_NONE,
+                PRIMITIVE_BOX,
+                PRIMITIVE_CYLINDER,
+                PRIMITIVE_FLOOR
+            } primitive_type_t;
+
+            // Fields of a box, cylinder, or floor, as in SolidBox, Webots'
+            // barrel-like cylinder protos, and Floor
+            typedef struct {
+                vec3_t translation;
+                rotation_t rotation;
+                vec3_t size;
+                double radius;
+                double height;
+            } primitive_t;
+
+            static primitive_type_t primitiveType(const string_view line)
+            {
+                const auto type = ParserUtils::node_type(line);
+
+                return type.empty() ? PRIMITIVE_NONE :
+                    type == "Floor" ? PRIMITIVE_FLOOR :
+                    ParserUtils::string_ends_with(type, "Box") ?
+                    PRIMITIVE_BOX :
+                    ParserUtils::string_ends_with(type, "Cylinder") ?
+                    PRIMITIVE_CYLINDER : PRIMITIVE_NONE;
+            }
+
+            static void parsePrimitive(const string_view line,
+                    primitive_t & primitive, char * name)
+            {
+                ParserUtils::try_parse_vec3(line, "translation",
+                        primitive.translation);
+
+                ParserUtils::try_parse_rotation(line, "rotation",
+                        primitive.rotation);
+
+                ParserUtils::try_parse_vec3(line, "size", primitive.size);
+
+                ParserUtils::try_parse_double(line, "radius", primitive.radius);
+
+                ParserUtils::try_parse_double(line, "height", primitive.height);
+
+                ParserUtils::try_parse_name(line, name);
+            }
+
+            static void addPrimitive(const primitive_type_t type,
+                    const primitive_t & primitive, const char * name,
+                    World & world)
+            {
+                switch (type) {
+                    case PRIMITIVE_BOX:
+                        world.add_box(primitive.translation,
+                                primitive.rotation, primitive.size, name);
+                        break;
+                    case PRIMITIVE_CYLINDER:
+                        world.add_cylinder(primitive.translation,
+                                primitive.radius, primitive.height, name);
+                        break;
+                    case PRIMITIVE_FLOOR:
+                        world.add_plane(primitive.translation.z,
+                                name[0] ? name : "floor");
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            static bool endOfBlock(const string_view line) {
 
                 return ParserUtils::string_contains(line, "}");
             }
 
-            static void parseWall(const string line, Wall * wall)
+            static void parseWall(const string_view line, Wall & wall,
+                    char * name)
             {
                 ParserUtils::try_parse_vec3(line, "translation",
-                        wall->translation);
+                        wall.translation);
 
                 ParserUtils::try_parse_rotation(line, "rotation",
-                        wall->rotation);
+                        wall.rotation);
 
                 ParserUtils::try_parse_vec3(line, "size",
-                        wall->size);
+                        wall.size);
 
-                ParserUtils::try_parse_name(line, wall->name);
+                ParserUtils::try_parse_name(line, name);
             }
 
-            static void parseRobot(const string line, World & world)
+            static void parseRobot(const string_view line, World & world)
             {
                 vec3_t trans = {};
                 if (ParserUtils::try_parse_vec3(line, "translation",
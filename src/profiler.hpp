@@ -0,0 +1,367 @@
+/*
+   Optional counters and timers for the simulation's hot paths
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+using namespace std;
+
+// Define SIMSENS_PROFILE before including anything from simsensors (e.g.
+// -DSIMSENS_PROFILE) to count and time the hot paths.  Without it the
+// macros below expand to nothing, so the library pays nothing for them.
+#ifdef SIMSENS_PROFILE
+#define SIMSENS_COUNT(counter, n) \
+    simsens::Profiler::count(simsens::Profiler::counter, n)
+#define SIMSENS_SCOPE(scope) \
+    simsens::Profiler::Timer simsens_scope_timer(simsens::Profiler::scope)
+#else
+#define SIMSENS_COUNT(counter, n) do {} while (0)
+#define SIMSENS_SCOPE(scope) do {} while (0)
+#endif
+
+namespace simsens {
+
+    // Each thread records into a buffer of its own, written only by that
+    // thread, so recording takes no lock; only a thread's first record
+    // locks, to register its buffer.  Snapshots and traces read every
+    // buffer while they may still be written, and so are exact only once
+    // the threads being profiled are idle.
+    class Profiler {
+
+        public:
+
+#ifdef SIMSENS_PROFILE
+            static constexpr bool ENABLED = true;
+#else
+            static constexpr bool ENABLED = false;
+#endif
+
+            typedef enum {
+                COUNTER_BEAMS,
+                COUNTER_HITS,
+                COUNTER_RAY_TESTS,
+                COUNTER_CULLED_WALLS,
+                COUNTER_NODES_VISITED,
+                COUNTER_COUNT
+            } counter_t;
+
+            typedef enum {
+                SCOPE_READ,
+                SCOPE_READ_BATCH,
+                SCOPE_TICK,
+                SCOPE_COLLIDED,
+                SCOPE_PARSE_WORLD,
+                SCOPE_PARSE_ROBOT,
+                SCOPE_VISUALIZE,
+                SCOPE_COUNT
+            } scope_t;
+
+            // Totals over every thread since the last reset
+            typedef struct {
+                uint64_t counters[COUNTER_COUNT];
+                uint64_t calls[SCOPE_COUNT];
+                uint64_t total_ns[SCOPE_COUNT];
+            } stats_t;
+
+            static const char * counter_name(const counter_t counter)
+            {
+                static const char * names[COUNTER_COUNT] = {
+                    "beams", "hits", "ray_tests", "culled_walls",
+                    "nodes_visited"
+                };
+
+                return names[counter];
+            }
+
+            static const char * scope_name(const scope_t scope)
+            {
+                static const char * names[SCOPE_COUNT] = {
+                    "Rangefinder::read", "Rangefinder::read_batch",
+                    "Robot::tick", "World::collided", "WorldParser::parse",
+                    "RobotParser::parse", "RangefinderVisualizer"
+                };
+
+                return names[scope];
+            }
+
+            static void count(const counter_t counter, const uint64_t n=1)
+            {
+                auto & total = local().counters[counter];
+
+                // Only this thread writes it, so no read-modify-write
+                total.store(total.load(memory_order_relaxed) + n,
+                        memory_order_relaxed);
+            }
+
+            // Times its own lifetime as one call of the scope
+            class Timer {
+
+                public:
+
+                    Timer(const scope_t scope)
+                    {
+                        this->scope = scope;
+                        start_ns = now_ns();
+                    }
+
+                    ~Timer()
+                    {
+                        record(scope, start_ns, now_ns() - start_ns);
+                    }
+
+                private:
+
+                    scope_t scope;
+                    uint64_t start_ns;
+            };
+
+            static stats_t snapshot()
+            {
+                stats_t stats = {};
+
+                auto & r = registry();
+                lock_guard<mutex> lock(r.buffers_mutex);
+
+                for (const auto & buffer : r.buffers) {
+
+                    for (int k=0; k<COUNTER_COUNT; ++k) {
+                        stats.counters[k] +=
+                            buffer->counters[k].load(memory_order_relaxed);
+                    }
+
+                    for (int k=0; k<SCOPE_COUNT; ++k) {
+                        stats.calls[k] +=
+                            buffer->calls[k].load(memory_order_relaxed);
+                        stats.total_ns[k] +=
+                            buffer->total_ns[k].load(memory_order_relaxed);
+                    }
+                }
+
+                return stats;
+            }
+
+            // Clears every counter, timer, and traced call
+            static void reset()
+            {
+                auto & r = registry();
+                lock_guard<mutex> lock(r.buffers_mutex);
+
+                for (const auto & buffer : r.buffers) {
+
+                    for (auto & counter : buffer->counters) {
+                        counter.store(0, memory_order_relaxed);
+                    }
+
+                    for (int k=0; k<SCOPE_COUNT; ++k) {
+                        buffer->calls[k].store(0, memory_order_relaxed);
+                        buffer->total_ns[k].store(0, memory_order_relaxed);
+                    }
+
+                    buffer->written.store(0, memory_order_release);
+                }
+            }
+
+            // Writes each thread's latest timed calls (up to
+            // EVENTS_PER_THREAD of them) as complete events, and the
+            // counters as a counter event, in the Chrome trace format read
+            // by chrome://tracing and Perfetto
+            static bool write_chrome_trace(const char * file_name)
+            {
+                FILE * fp = fopen(file_name, "w");
+
+                if (!fp) {
+                    fprintf(stderr, "Unable to open file %s for output\n",
+                            file_name);
+                    return false;
+                }
+
+                const auto stats = snapshot();
+
+                fprintf(fp, "{\"traceEvents\":[\n");
+
+                auto & r = registry();
+
+                uint64_t last_ns = 0;
+
+                {
+                    lock_guard<mutex> lock(r.buffers_mutex);
+
+                    for (const auto & buffer : r.buffers) {
+
+                        fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\","
+                                "\"pid\":1,\"tid\":%u,"
+                                "\"args\":{\"name\":\"thread %u\"}},\n",
+                                buffer->thread_id, buffer->thread_id);
+
+                        const auto written =
+                            buffer->written.load(memory_order_acquire);
+
+                        const auto first = written > EVENTS_PER_THREAD ?
+                            written - EVENTS_PER_THREAD : 0;
+
+                        for (auto k=first; k<written; ++k) {
+
+                            const auto & event =
+                                buffer->events[k % EVENTS_PER_THREAD];
+
+                            fprintf(fp, "{\"name\":\"%s\",\"cat\":\"simsensors\","
+                                    "\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                                    "\"ts\":%.3f,\"dur\":%.3f},\n",
+                                    scope_name(event.scope), buffer->thread_id,
+                                    event.start_ns / 1e3,
+                                    event.duration_ns / 1e3);
+
+                            last_ns = max(last_ns,
+                                    event.start_ns + event.duration_ns);
+                        }
+                    }
+                }
+
+                fprintf(fp, "{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,"
+                        "\"ts\":%.3f,\"args\":{", last_ns / 1e3);
+
+                for (int k=0; k<COUNTER_COUNT; ++k) {
+                    fprintf(fp, "%s\"%s\":%llu", k > 0 ? "," : "",
+                            counter_name((counter_t)k),
+                            (unsigned long long)stats.counters[k]);
+                }
+
+                fprintf(fp, "}}\n]}\n");
+
+                const auto ok = fclose(fp) == 0;
+
+                if (!ok) {
+                    fprintf(stderr, "Unable to write trace %s\n", file_name);
+                }
+
+                return ok;
+            }
+
+            static void dump()
+            {
+                const auto stats = snapshot();
+
+                printf("Profile: \n");
+
+                for (int k=0; k<COUNTER_COUNT; ++k) {
+                    printf("  %-24s %llu\n", counter_name((counter_t)k),
+                            (unsigned long long)stats.counters[k]);
+                }
+
+                for (int k=0; k<SCOPE_COUNT; ++k) {
+                    if (stats.calls[k] > 0) {
+                        printf("  %-24s %llu calls, %.3f ms\n",
+                                scope_name((scope_t)k),
+                                (unsigned long long)stats.calls[k],
+                                stats.total_ns[k] / 1e6);
+                    }
+                }
+
+                printf("\n");
+            }
+
+            // Timed calls kept per thread for the trace; older ones are
+            // overwritten
+            static constexpr uint64_t EVENTS_PER_THREAD = 1 << 16;
+
+        private:
+
+            typedef struct {
+                scope_t scope;
+                uint64_t start_ns;
+                uint64_t duration_ns;
+            } event_t;
+
+            typedef struct {
+                uint32_t thread_id;
+                atomic<uint64_t> counters[COUNTER_COUNT];
+                atomic<uint64_t> calls[SCOPE_COUNT];
+                atomic<uint64_t> total_ns[SCOPE_COUNT];
+                vector<event_t> events;
+                atomic<uint64_t> written;
+            } buffer_t;
+
+            // Buffers outlive their threads, so that a snapshot still
+            // counts the work of threads that have exited
+            typedef struct {
+                mutex buffers_mutex;
+                vector<unique_ptr<buffer_t>> buffers;
+                chrono::steady_clock::time_point epoch;
+            } registry_t;
+
+            static registry_t & registry()
+            {
+                static registry_t r = {{}, {}, chrono::steady_clock::now()};
+                return r;
+            }
+
+            static buffer_t & local()
+            {
+                thread_local buffer_t * buffer = nullptr;
+
+                if (!buffer) {
+
+                    auto & r = registry();
+                    lock_guard<mutex> lock(r.buffers_mutex);
+
+                    r.buffers.push_back(unique_ptr<buffer_t>(new buffer_t()));
+
+                    buffer = r.buffers.back().get();
+                    buffer->thread_id = r.buffers.size() - 1;
+                    buffer->events.resize(EVENTS_PER_THREAD);
+                }
+
+                return *buffer;
+            }
+
+            static uint64_t now_ns()
+            {
+                return chrono::duration_cast<chrono::nanoseconds>(
+                        chrono::steady_clock::now() - registry().epoch).count();
+            }
+
+            static void record(const scope_t scope, const uint64_t start_ns,
+                    const uint64_t duration_ns)
+            {
+                auto & buffer = local();
+
+                auto & calls = buffer.calls[scope];
+                calls.store(calls.load(memory_order_relaxed) + 1,
+                        memory_order_relaxed);
+
+                auto & total = buffer.total_ns[scope];
+                total.store(total.load(memory_order_relaxed) + duration_ns,
+                        memory_order_relaxed);
+
+                const auto written = buffer.written.load(memory_order_relaxed);
+
+                buffer.events[written % EVENTS_PER_THREAD] =
+                    event_t {scope, start_ns, duration_ns};
+
+                buffer.written.store(written + 1, memory_order_release);
+            }
+    };
+
+}
@@ -0,0 +1,98 @@
+/*
+   Layout of binary scan logs
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simsensors/src/types.h>
+
+namespace simsens {
+
+    // A scan log is a header, a table of the sensors recorded, and then
+    // fixed-size records appended one per tick, so that record k is found
+    // by arithmetic and a log cut short by a crash keeps every whole
+    // record that reached the file; ScanLogWriter bounds how many it may
+    // still hold in memory.  Each record is a record_t followed by every
+    // sensor's image in millimeters (-1 for no return), back to back in
+    // table order.  Like the binary caches, logs are stored in native
+    // layout and read back on the kind of machine that wrote them.
+    class ScanLogFormat {
+
+        public:
+
+            static constexpr uint32_t VERSION = 1;
+
+            static constexpr char MAGIC[8] = {
+                'S', 'I', 'M', 'S', 'L', 'O', 'G', '\n'};
+
+            typedef struct {
+                char magic[8];
+                uint32_t version;
+                uint32_t sensor_count;
+                uint64_t record_size;
+            } header_t;
+
+            typedef struct {
+                char name[64];
+                int32_t width;
+                int32_t height;
+            } sensor_t;
+
+            static constexpr uint32_t FLAG_COLLIDED = 1;
+
+            // Bit k of updated is set if sensor k was read for the record,
+            // rather than carried over from an earlier one; sensors past
+            // the 32nd always count as read
+            typedef struct {
+                double time_s;
+                pose_t pose;
+                uint32_t flags;
+                uint32_t updated;
+            } record_t;
+
+            static bool was_updated(const record_t & record,
+                    const size_t sensor_index)
+            {
+                return sensor_index >= 32 ||
+                    ((record.updated >> sensor_index) & 1);
+            }
+
+            // Header and record sizes are multiples of eight bytes, so the
+            // doubles in every record stay aligned in a mapping
+            static uint64_t record_size(const sensor_t * sensors,
+                    const uint32_t count)
+            {
+                uint64_t size = sizeof(record_t);
+
+                for (uint32_t k=0; k<count; ++k) {
+                    size += sensors[k].width * sensors[k].height *
+                        sizeof(int32_t);
+                }
+
+                return (size + 7) & ~(uint64_t)7;
+            }
+
+            static uint64_t records_offset(const uint32_t sensor_count)
+            {
+                return sizeof(header_t) + sensor_count * sizeof(sensor_t);
+            }
+    };
+
+}
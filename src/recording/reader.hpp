@@ -0,0 +1,274 @@
+/*
+   Memory-mapped reader and replayer for binary scan logs
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/parsers/mapped_file.hpp>
+#include <simsensors/src/recording/format.hpp>
+#include <simsensors/src/sensors/rangefinder.hpp>
+#include <simsensors/src/world.hpp>
+
+namespace simsens {
+
+    // Gives random access to the records of a scan log, pointing into the
+    // mapping rather than copying
+    class ScanLogReader {
+
+        public:
+
+            // How far a replay's reads came from the logged ones
+            typedef struct {
+                size_t frames;
+                size_t beams;
+                size_t mismatched_beams;
+                int max_error_mm;
+            } replay_t;
+
+            ScanLogReader(const char * file_name) : file(file_name)
+            {
+                header = nullptr;
+                sensors = nullptr;
+                records = nullptr;
+                count = 0;
+
+                const auto contents = file.contents();
+
+                if (contents.size() < sizeof(ScanLogFormat::header_t)) {
+                    return;
+                }
+
+                auto h = (const ScanLogFormat::header_t *)contents.data();
+
+                const auto offset = ScanLogFormat::records_offset(
+                        h->sensor_count);
+
+                if (memcmp(h->magic, ScanLogFormat::MAGIC,
+                            sizeof(h->magic)) != 0 ||
+                        h->version != ScanLogFormat::VERSION ||
+                        contents.size() < offset) {
+                    return;
+                }
+
+                auto s = (const ScanLogFormat::sensor_t *)(
+                        contents.data() + sizeof(*h));
+
+                if (h->record_size !=
+                        ScanLogFormat::record_size(s, h->sensor_count)) {
+                    return;
+                }
+
+                header = h;
+                sensors = s;
+                records = contents.data() + offset;
+
+                // A partial record at the end is left out
+                count = (contents.size() - offset) / h->record_size;
+
+                sensor_offsets.resize(h->sensor_count);
+
+                size_t beams = 0;
+                for (uint32_t k=0; k<h->sensor_count; ++k) {
+                    sensor_offsets[k] = beams;
+                    beams += sensors[k].width * sensors[k].height;
+                }
+            }
+
+            bool valid() const
+            {
+                return header != nullptr;
+            }
+
+            // Number of complete records
+            size_t size() const
+            {
+                return count;
+            }
+
+            size_t sensor_count() const
+            {
+                return header ? header->sensor_count : 0;
+            }
+
+            const ScanLogFormat::sensor_t & sensor(const size_t index) const
+            {
+                return sensors[index];
+            }
+
+            // Index of the named sensor, or -1
+            int find_sensor(const char * name) const
+            {
+                for (size_t k=0; k<sensor_count(); ++k) {
+                    if (strncmp(sensors[k].name, name,
+                                sizeof(sensors[k].name)) == 0) {
+                        return k;
+                    }
+                }
+
+                return -1;
+            }
+
+            double time(const size_t index) const
+            {
+                return record(index).time_s;
+            }
+
+            const pose_t & pose(const size_t index) const
+            {
+                return record(index).pose;
+            }
+
+            bool collided(const size_t index) const
+            {
+                return record(index).flags & ScanLogFormat::FLAG_COLLIDED;
+            }
+
+            // Whether the sensor was read for the record, rather than its
+            // image carried over from an earlier one
+            bool updated(const size_t index, const size_t sensor_index) const
+            {
+                return ScanLogFormat::was_updated(record(index), sensor_index);
+            }
+
+            const int * distances(const size_t index,
+                    const size_t sensor_index) const
+            {
+                return (const int *)(records + index * header->record_size +
+                        sizeof(ScanLogFormat::record_t)) +
+                    sensor_offsets[sensor_index];
+            }
+
+            // Index of the first record at or after the given time, or
+            // size() if there is none; records are in time order
+            size_t find(const double time_s) const
+            {
+                size_t lo = 0;
+                size_t hi = count;
+
+                while (lo < hi) {
+                    const auto mid = lo + (hi - lo) / 2;
+                    if (time(mid) < time_s) {
+                        lo = mid + 1;
+                    }
+                    else {
+                        hi = mid;
+                    }
+                }
+
+                return lo;
+            }
+
+            // Reads the rangefinder again at the logged poses of records
+            // [first, first+frames) in which the given sensor was read, and
+            // compares its images with the logged ones.  A noisy sensor
+            // matches only if its noise scan number is set to where the
+            // log's started.
+            replay_t replay(const size_t sensor_index,
+                    Rangefinder & rangefinder, World & world,
+                    const size_t first=0, size_t frames=SIZE_MAX,
+                    const int tolerance_mm=0) const
+            {
+                replay_t result = {};
+
+                const auto & logged = sensors[sensor_index];
+
+                if (rangefinder.width != logged.width ||
+                        rangefinder.height != logged.height || first >= count) {
+                    return result;
+                }
+
+                frames = min(frames, count - first);
+
+                const size_t frame_size = logged.width * logged.height;
+
+                vector<size_t> indices;
+                vector<pose_t> poses;
+                vector<int> images(REPLAY_CHUNK * frame_size);
+
+                // Gathers up to a chunk of records to read as one batch
+                for (size_t next=first; next<first+frames; ) {
+
+                    indices.clear();
+                    poses.clear();
+
+                    for (; next<first+frames && indices.size()<REPLAY_CHUNK;
+                            ++next) {
+                        if (updated(next, sensor_index)) {
+                            indices.push_back(next);
+                            poses.push_back(pose(next));
+                        }
+                    }
+
+                    rangefinder.read_batch(poses.data(), poses.size(), world,
+                            images.data());
+
+                    for (size_t k=0; k<indices.size(); ++k) {
+
+                        const auto expected = distances(indices[k],
+                                sensor_index);
+                        const auto actual = &images[k * frame_size];
+
+                        for (size_t j=0; j<frame_size; ++j) {
+
+                            const auto error = abs(actual[j] - expected[j]);
+
+                            result.max_error_mm =
+                                max(result.max_error_mm, error);
+
+                            result.mismatched_beams += error > tolerance_mm;
+                        }
+                    }
+
+                    result.frames += indices.size();
+                }
+
+                result.beams = result.frames * frame_size;
+
+                return result;
+            }
+
+        private:
+
+            // Poses replayed per batch read
+            static constexpr size_t REPLAY_CHUNK = 256;
+
+            MappedFile file;
+
+            const ScanLogFormat::header_t * header;
+            const ScanLogFormat::sensor_t * sensors;
+            const char * records;
+            size_t count;
+
+            // Where each sensor's image starts within a record, in beams
+            vector<size_t> sensor_offsets;
+
+            const ScanLogFormat::record_t & record(const size_t index) const
+            {
+                return *(const ScanLogFormat::record_t *)(
+                        records + index * header->record_size);
+            }
+    };
+
+}
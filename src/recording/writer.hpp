@@ -0,0 +1,332 @@
+/*
+   Background writer for binary scan logs
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include <simsensors/src/recording/format.hpp>
+#include <simsensors/src/robot.hpp>
+
+namespace simsens {
+
+    // Appends records to a scan log.  Records are copied into one of a
+    // fixed set of blocks allocated when the log is opened; a full block
+    // goes to a background thread to be written while the next one fills.
+    // A record has to wait only if every block is still being written.
+    // A partly filled block is also handed over once it has held records
+    // for max_latency_s, so a crash loses at most that long of the log.
+    class ScanLogWriter {
+
+        public:
+
+            ScanLogWriter()
+            {
+                fp = nullptr;
+                record_size = 0;
+                total_beams = 0;
+                records_per_block = 0;
+                max_latency_s = 0;
+                fill = 0;
+                producer = 0;
+                consumer = 0;
+                ready = 0;
+                stopping = false;
+                failed = false;
+            }
+
+            ~ScanLogWriter()
+            {
+                close();
+            }
+
+            // Starts a new log of the given sensors' images
+            bool open(const string & file_name,
+                    const vector<ScanLogFormat::sensor_t> & sensors,
+                    const size_t records_per_block=256,
+                    const size_t block_count=4,
+                    const double max_latency_s=1)
+            {
+                close();
+
+                fp = fopen(file_name.c_str(), "wb");
+
+                if (!fp) {
+                    fprintf(stderr, "Unable to open file %s for output\n",
+                            file_name.c_str());
+                    return false;
+                }
+
+                ScanLogFormat::header_t header = {};
+                memcpy(header.magic, ScanLogFormat::MAGIC,
+                        sizeof(header.magic));
+                header.version = ScanLogFormat::VERSION;
+                header.sensor_count = sensors.size();
+                header.record_size = ScanLogFormat::record_size(
+                        sensors.data(), sensors.size());
+
+                // A short write here is reported by close(), like any other
+                failed = fwrite(&header, sizeof(header), 1, fp) != 1 ||
+                    fwrite(sensors.data(), sizeof(sensors[0]), sensors.size(),
+                            fp) != sensors.size();
+
+                record_size = header.record_size;
+
+                total_beams = 0;
+                for (const auto & sensor : sensors) {
+                    total_beams += sensor.width * sensor.height;
+                }
+
+                this->records_per_block = max(records_per_block, (size_t)1);
+                this->max_latency_s = max_latency_s;
+
+                blocks.resize(max(block_count, (size_t)2));
+                block_bytes.assign(blocks.size(), 0);
+
+                for (auto & block : blocks) {
+                    block.assign(this->records_per_block * record_size, 0);
+                }
+
+                fill = 0;
+                producer = 0;
+                consumer = 0;
+                ready = 0;
+                stopping = false;
+
+                writer = thread(&ScanLogWriter::write_loop, this);
+
+                return true;
+            }
+
+            // Logs the sensors a robot has scheduled, in handle order
+            bool open(const string & file_name, const Robot & robot,
+                    const size_t records_per_block=256,
+                    const size_t block_count=4,
+                    const double max_latency_s=1)
+            {
+                vector<ScanLogFormat::sensor_t> sensors;
+
+                for (const auto & scheduled : robot.scheduled) {
+
+                    ScanLogFormat::sensor_t sensor = {};
+
+                    const auto rangefinder = scheduled.rangefinder;
+
+                    memcpy(sensor.name, rangefinder->name,
+                            sizeof(sensor.name) - 1);
+                    sensor.width = rangefinder->width;
+                    sensor.height = rangefinder->height;
+
+                    sensors.push_back(sensor);
+                }
+
+                return open(file_name, sensors, records_per_block,
+                        block_count, max_latency_s);
+            }
+
+            // Appends one record; distances_mm holds every sensor's image,
+            // back to back in the order they were given to open(), and bit
+            // k of updated says whether sensor k's is new
+            void record(const double time_s, const pose_t & pose,
+                    const bool collided, const int * distances_mm,
+                    const uint32_t updated=UINT32_MAX)
+            {
+                if (!fp) {
+                    return;
+                }
+
+                if (fill == records_per_block) {
+                    submit();
+                }
+
+                if (fill == 0) {
+                    first_fill = clock::now();
+                }
+
+                auto p = &blocks[producer][fill * record_size];
+
+                ScanLogFormat::record_t header = {};
+                header.time_s = time_s;
+                header.pose = pose;
+                header.flags = collided ? ScanLogFormat::FLAG_COLLIDED : 0;
+                header.updated = updated;
+
+                memcpy(p, &header, sizeof(header));
+                memcpy(p + sizeof(header), distances_mm,
+                        total_beams * sizeof(int32_t));
+
+                fill++;
+
+                if (fill < records_per_block &&
+                        chrono::duration<double>(clock::now() - first_fill)
+                        .count() >= max_latency_s) {
+                    submit();
+                }
+            }
+
+            // Appends the robot's frame from its latest tick, marking the
+            // sensors that tick read
+            void record(const double time_s, const pose_t & pose,
+                    const bool collided, const Robot & robot)
+            {
+                uint32_t updated = 0;
+
+                for (size_t k=0; k<min(robot.scheduled.size(),
+                            (size_t)32); ++k) {
+                    if (robot.scheduled[k].updated) {
+                        updated |= 1u << k;
+                    }
+                }
+
+                record(time_s, pose, collided, robot.frame.data(), updated);
+            }
+
+            // Hands the records so far to the writer thread
+            void flush()
+            {
+                if (fp && fill > 0) {
+                    submit();
+                }
+            }
+
+            // Writes everything recorded and closes the log; returns false
+            // if any write failed
+            bool close()
+            {
+                if (!fp) {
+                    return true;
+                }
+
+                flush();
+
+                {
+                    lock_guard<mutex> lock(state_mutex);
+                    stopping = true;
+                }
+
+                block_written.notify_all();
+                block_ready.notify_all();
+
+                writer.join();
+
+                const auto ok = fclose(fp) == 0 && !failed;
+
+                if (!ok) {
+                    fprintf(stderr, "Unable to write scan log\n");
+                }
+
+                fp = nullptr;
+
+                return ok;
+            }
+
+        private:
+
+            typedef chrono::steady_clock clock;
+
+            FILE * fp;
+
+            uint64_t record_size;
+            size_t total_beams;
+
+            // A ring of blocks: the producer fills blocks[producer] while
+            // the writer drains the ready blocks starting at consumer
+            vector<vector<char>> blocks;
+            vector<size_t> block_bytes;
+            size_t records_per_block;
+            double max_latency_s;
+            clock::time_point first_fill;
+            size_t fill;
+            size_t producer;
+            size_t consumer;
+            size_t ready;
+            bool stopping;
+            bool failed;
+
+            thread writer;
+            mutex state_mutex;
+            condition_variable block_ready;
+            condition_variable block_written;
+
+            void submit()
+            {
+                unique_lock<mutex> lock(state_mutex);
+
+                block_bytes[producer] = fill * record_size;
+                ready++;
+
+                block_ready.notify_one();
+
+                // Wait for a free block to fill next
+                block_written.wait(lock, [this] {
+                        return ready < blocks.size();
+                        });
+
+                producer = (producer + 1) % blocks.size();
+                fill = 0;
+            }
+
+            void write_loop()
+            {
+                while (true) {
+
+                    size_t index = 0;
+
+                    {
+                        unique_lock<mutex> lock(state_mutex);
+
+                        block_ready.wait(lock, [this] {
+                                return ready > 0 || stopping;
+                                });
+
+                        if (ready == 0) {
+                            return;
+                        }
+
+                        index = consumer;
+                    }
+
+                    const auto bytes = block_bytes[index];
+
+                    // Flushed, so that the records survive a crash of this
+                    // process
+                    const auto wrote = fwrite(blocks[index].data(), 1, bytes,
+                            fp) == bytes && fflush(fp) == 0;
+
+                    {
+                        lock_guard<mutex> lock(state_mutex);
+                        failed = failed || !wrote;
+                        consumer = (consumer + 1) % blocks.size();
+                        ready--;
+                    }
+
+                    block_written.notify_one();
+                }
+            }
+    };
+
+}
@@ -1,4 +1,4 @@
-/* 
+/*
    Simple robot representation for simulators
 
    Copyright (C) 2025 Simon D. Levy
@@ -18,7 +18,10 @@
 
 #pragma once
 
+#include <math.h>
+
 #include <map>
+#include <vector>
 
 #include <simsensors/src/sensors/rangefinder.hpp>
 
@@ -30,12 +33,137 @@ namespace simsens {
 
             std::map<string, Rangefinder *> rangefinders;
 
+            // Adds the named rangefinder to the schedule, to be read at
+            // the given rate (or every tick, for zero), and returns its
+            // handle, or -1 if the robot has no such sensor.  Scheduling
+            // grows the frame, so pointers from distances() are valid only
+            // until the next call.
+            int schedule(const string & name, const double rate_hz=0)
+            {
+                const auto entry = rangefinders.find(name);
+
+                if (entry == rangefinders.end()) {
+                    return -1;
+                }
+
+                const auto rangefinder = entry->second;
+
+                scheduled_t sensor = {};
+                sensor.rangefinder = rangefinder;
+                sensor.period_s = rate_hz > 0 ? 1 / rate_hz : 0;
+                sensor.next_due_s = -INFINITY;
+                sensor.last_read_s = NAN;
+                sensor.offset = frame.size();
+                sensor.updated = false;
+
+                scheduled.push_back(sensor);
+
+                frame.resize(frame.size() +
+                        rangefinder->width * rangefinder->height, -1);
+
+                return (int)scheduled.size() - 1;
+            }
+
+            // Reads every scheduled sensor that is due at the given time
+            // from the given pose, adjusting the pose for the world once
+            // for all of them, and returns how many were read.  A sensor
+            // that falls more than a period behind skips the reads it
+            // missed rather than catching up.
+            template <typename T=double>
+            size_t tick(const double time_s, const pose_t & robot_pose,
+                    World & world)
+            {
+                SIMSENS_SCOPE(SCOPE_TICK);
+
+                pose_t robpose = {};
+                bool adjusted = false;
+                size_t count = 0;
+
+                for (auto & sensor : scheduled) {
+
+                    sensor.updated =
+                        time_s >= sensor.next_due_s - SCHEDULE_TOLERANCE_S;
+
+                    if (!sensor.updated) {
+                        continue;
+                    }
+
+                    if (!adjusted) {
+                        robpose = world.adjust_pose(robot_pose);
+                        adjusted = true;
+                    }
+
+                    sensor.rangefinder->read_adjusted<T>(robpose,
+                            world, RangefinderOutput().distances(
+                                &frame[sensor.offset]));
+
+                    sensor.next_due_s = sensor.next_due_s == -INFINITY ?
+                        time_s + sensor.period_s :
+                        sensor.next_due_s + sensor.period_s;
+
+                    if (sensor.next_due_s <= time_s) {
+                        sensor.next_due_s = time_s + sensor.period_s;
+                    }
+
+                    sensor.last_read_s = time_s;
+
+                    count++;
+                }
+
+                return count;
+            }
+
+            // The sensor's latest image, in millimeters, within the frame
+            // shared by all scheduled sensors; -1 everywhere until first read
+            const int * distances(const int handle) const
+            {
+                return &frame[scheduled[handle].offset];
+            }
+
+            // Whether the last tick read the sensor
+            bool updated(const int handle) const
+            {
+                return scheduled[handle].updated;
+            }
+
+            // Time of the sensor's latest read, or NaN before the first
+            double last_read_time(const int handle) const
+            {
+                return scheduled[handle].last_read_s;
+            }
+
+            Rangefinder & rangefinder(const int handle) const
+            {
+                return *scheduled[handle].rangefinder;
+            }
+
             void dump()
             {
                 for (auto rangefinder : rangefinders) {
                     rangefinder.second->dump();
                 }
             }
+
+        private:
+
+            friend class ScanLogWriter;
+
+            typedef struct {
+                Rangefinder * rangefinder;
+                double period_s;
+                double next_due_s;
+                double last_read_s;
+                size_t offset;
+                bool updated;
+            } scheduled_t;
+
+            // Absorbs rounding in tick times built up by adding time steps
+            static constexpr double SCHEDULE_TOLERANCE_S = 1e-9;
+
+            std::vector<scheduled_t> scheduled;
+
+            // Every scheduled sensor's image, back to back
+            std::vector<int> frame;
     };
 
 }
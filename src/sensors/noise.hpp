@@ -0,0 +1,220 @@
+/*
+   Reproducible range noise and dropout for simulated rangefinders
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <simsensors/src/simd.hpp>
+
+namespace simsens {
+
+    // Noise added to each distance a rangefinder reports: Gaussian with a
+    // standard deviation that can grow with range, then rounding to the
+    // sensor's resolution, then dropout of the whole return.  All zero
+    // (the default) means a noise-free sensor.
+    //
+    // The random numbers come from a counter-based generator: each beam's
+    // samples are a hash of the seed, the scan number, and the beam's pixel
+    // index, so a scan is the same however its beams are split among
+    // threads, and any scan can be reproduced from its number alone.
+    class RangefinderNoise {
+
+        public:
+
+            // Standard deviation is sigma_m + sigma_per_m * distance
+            double sigma_m;
+            double sigma_per_m;
+
+            // Chance that a beam returns nothing
+            double dropout_probability;
+
+            // Distances are rounded to a multiple of this, if positive
+            double resolution_m;
+
+            uint64_t seed;
+
+            // Number of the next scan; read() uses one per image and
+            // read_batch() one per pose.  Set it to replay earlier scans.
+            uint64_t scan;
+
+            RangefinderNoise()
+            {
+                sigma_m = 0;
+                sigma_per_m = 0;
+                dropout_probability = 0;
+                resolution_m = 0;
+                seed = 0;
+                scan = 0;
+            }
+
+            bool enabled() const
+            {
+                return sigma_m > 0 || sigma_per_m > 0 ||
+                    dropout_probability > 0 || resolution_m > 0;
+            }
+
+            // Fills samples[0, count) with standard normal values and
+            // samples[count, 2*count) with uniform values in (0,1) for the
+            // beams of one scan
+            void generate(const uint64_t scan_number, const size_t count,
+                    float * samples) const
+            {
+                const auto key = splitmix64(seed ^ splitmix64(scan_number));
+
+                const auto key0 = (uint32_t)key;
+                const auto key1 = (uint32_t)(key >> 32);
+
+                // Hash every counter first, in one vectorizable pass, then
+                // turn pairs of uniforms into pairs of normals
+                hash_uniforms(key0, key1, 0, 2 * count, samples);
+
+                for (size_t k=0; k+1<count; k+=2) {
+                    box_muller(samples[k], samples[k+1]);
+                }
+
+                // An odd beam out uses the next counter as its partner
+                if (count % 2) {
+                    float spare = uniform(hash(key0, key1, 2 * count));
+                    box_muller(samples[count-1], spare);
+                }
+            }
+
+            // Applies the model to a distance, with INFINITY meaning no
+            // return, using one beam's normal and uniform samples
+            double apply(const double dist, const float normal,
+                    const float uniform) const
+            {
+                if (dist == INFINITY || uniform < dropout_probability) {
+                    return INFINITY;
+                }
+
+                auto noisy = dist + (sigma_m + sigma_per_m * dist) * normal;
+
+                if (resolution_m > 0) {
+                    noisy = round(noisy / resolution_m) * resolution_m;
+                }
+
+                return noisy > 0 ? noisy : 0;
+            }
+
+        private:
+
+            static uint64_t splitmix64(uint64_t x)
+            {
+                x += 0x9e3779b97f4a7c15;
+                x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+                x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+                return x ^ (x >> 31);
+            }
+
+            // Two rounds of the MurmurHash3 finalizer, keyed by the scan
+            static uint32_t hash(const uint32_t key0, const uint32_t key1,
+                    const uint32_t counter)
+            {
+                auto h = (counter * 0x9e3779b9u) ^ key0;
+
+                h ^= h >> 16; h *= 0x85ebca6bu; h ^= h >> 13;
+                h *= 0xc2b2ae35u; h ^= h >> 16;
+
+                h ^= key1;
+
+                h ^= h >> 16; h *= 0x85ebca6bu; h ^= h >> 13;
+                h *= 0xc2b2ae35u; h ^= h >> 16;
+
+                return h;
+            }
+
+            // Top 24 bits, centered in their interval so that zero and one
+            // never occur; exact in float
+            static float uniform(const uint32_t h)
+            {
+                return ((h >> 8) + 0.5f) * (1.f / 16777216);
+            }
+
+            // Replaces two uniforms with two independent standard normals
+            static void box_muller(float & u1, float & u2)
+            {
+                const auto r = sqrtf(-2 * logf(u1));
+                const auto theta = (float)(2 * M_PI) * u2;
+
+                u1 = r * cosf(theta);
+                u2 = r * sinf(theta);
+            }
+
+            // Uniforms for counters [first, first+count).  The vector path
+            // computes the same integers as the scalar one.
+            static void hash_uniforms(const uint32_t key0, const uint32_t key1,
+                    const uint32_t first, const size_t count, float * out)
+            {
+                size_t k = 0;
+
+#if defined(SIMSENS_AVX2)
+
+                const auto vkey0 = _mm256_set1_epi32((int)key0);
+                const auto vkey1 = _mm256_set1_epi32((int)key1);
+                const auto golden = _mm256_set1_epi32((int)0x9e3779b9u);
+                const auto c1 = _mm256_set1_epi32((int)0x85ebca6bu);
+                const auto c2 = _mm256_set1_epi32((int)0xc2b2ae35u);
+                const auto half = _mm256_set1_ps(0.5f);
+                const auto scale = _mm256_set1_ps(1.f / 16777216);
+
+                auto counter = _mm256_add_epi32(_mm256_set1_epi32((int)first),
+                        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+                const auto eight = _mm256_set1_epi32(8);
+
+                for (; k+8<=count; k+=8) {
+
+                    auto h = _mm256_xor_si256(
+                            _mm256_mullo_epi32(counter, golden), vkey0);
+
+                    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+                    h = _mm256_mullo_epi32(h, c1);
+                    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+                    h = _mm256_mullo_epi32(h, c2);
+                    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+
+                    h = _mm256_xor_si256(h, vkey1);
+
+                    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+                    h = _mm256_mullo_epi32(h, c1);
+                    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+                    h = _mm256_mullo_epi32(h, c2);
+                    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+
+                    // The top 24 bits convert to float exactly as signed
+                    const auto top = _mm256_cvtepi32_ps(
+                            _mm256_srli_epi32(h, 8));
+
+                    _mm256_storeu_ps(out + k,
+                            _mm256_mul_ps(_mm256_add_ps(top, half), scale));
+
+                    counter = _mm256_add_epi32(counter, eight);
+                }
+
+#endif
+
+                for (; k<count; ++k) {
+                    out[k] = uniform(hash(key0, key1, first + (uint32_t)k));
+                }
+            }
+    };
+
+}
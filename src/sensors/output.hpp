@@ -0,0 +1,257 @@
+/*
+   Caller-owned, strided output buffers for rangefinder reads
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <initializer_list>
+
+#include <simsensors/src/types.h>
+
+namespace simsens {
+
+    // Says where a read should write each channel it produces.  Channels
+    // left unset are skipped.  Each channel is a caller-owned buffer with
+    // byte strides between neighboring pixels, rows, and (for batches)
+    // frames, so that it can be a cv::Mat, a numpy array, or a region of
+    // shared memory; strides of zero mean tightly packed.
+    class RangefinderOutput {
+
+        friend class Rangefinder;
+
+        public:
+
+            typedef enum {
+                TYPE_INT32,
+                TYPE_UINT8,
+                TYPE_UINT16,
+                TYPE_FLOAT32,
+                TYPE_FLOAT64
+            } type_t;
+
+            typedef enum {
+                UNIT_MILLIMETERS,
+                UNIT_METERS
+            } unit_t;
+
+            RangefinderOutput()
+            {
+                distance = channel_t {};
+                point = channel_t {};
+                wall = channel_t {};
+                validity = channel_t {};
+                unit = UNIT_MILLIMETERS;
+            }
+
+            // Distance to the nearest obstacle less the sensor's offset.
+            // Integer types truncate, and unsigned ones saturate.  A beam
+            // that hits nothing within range gets -1 as int32 (as an int
+            // image always has), 0 as unsigned, or NaN as a float.
+            RangefinderOutput & distances(
+                    void * data,
+                    const type_t type=TYPE_INT32,
+                    const unit_t unit=UNIT_MILLIMETERS,
+                    const ptrdiff_t column_stride=0,
+                    const ptrdiff_t row_stride=0,
+                    const ptrdiff_t frame_stride=0)
+            {
+                distance = make_channel(data, type, 1,
+                        column_stride, row_stride, frame_stride);
+                this->unit = unit;
+                return *this;
+            }
+
+            // Where each beam hit, as x,y,z in world coordinates (float32 or
+            // float64), or NaNs for no hit
+            RangefinderOutput & hit_points(
+                    void * data,
+                    const type_t type=TYPE_FLOAT64,
+                    const ptrdiff_t column_stride=0,
+                    const ptrdiff_t row_stride=0,
+                    const ptrdiff_t frame_stride=0)
+            {
+                point = make_channel(data, type, 3,
+                        column_stride, row_stride, frame_stride);
+                return *this;
+            }
+
+            // Id of the obstacle each beam hit, or -1: a wall's index in
+            // world-file order, or a box's, cylinder's, or floor's index
+            // among its type plus 1, 2, or 3 times 2^28
+            RangefinderOutput & wall_ids(
+                    int32_t * data,
+                    const ptrdiff_t column_stride=0,
+                    const ptrdiff_t row_stride=0,
+                    const ptrdiff_t frame_stride=0)
+            {
+                wall = make_channel(data, TYPE_INT32, 1,
+                        column_stride, row_stride, frame_stride);
+                return *this;
+            }
+
+            // One where the beam hit an obstacle within range, zero elsewhere
+            RangefinderOutput & valid(
+                    uint8_t * data,
+                    const ptrdiff_t column_stride=0,
+                    const ptrdiff_t row_stride=0,
+                    const ptrdiff_t frame_stride=0)
+            {
+                validity = make_channel(data, TYPE_UINT8, 1,
+                        column_stride, row_stride, frame_stride);
+                return *this;
+            }
+
+        private:
+
+            typedef struct {
+                char * data;
+                type_t type;
+                ptrdiff_t item_size;
+                ptrdiff_t column_stride;
+                ptrdiff_t row_stride;
+                ptrdiff_t frame_stride;
+            } channel_t;
+
+            channel_t distance;
+            channel_t point;
+            channel_t wall;
+            channel_t validity;
+            unit_t unit;
+
+            static ptrdiff_t type_size(const type_t type)
+            {
+                return type == TYPE_INT32 ? sizeof(int32_t) :
+                    type == TYPE_UINT8 ? sizeof(uint8_t) :
+                    type == TYPE_UINT16 ? sizeof(uint16_t) :
+                    type == TYPE_FLOAT32 ? sizeof(float) : sizeof(double);
+            }
+
+            static channel_t make_channel(void * data, const type_t type,
+                    const int values,
+                    const ptrdiff_t column_stride,
+                    const ptrdiff_t row_stride,
+                    const ptrdiff_t frame_stride)
+            {
+                return channel_t {(char *)data, type,
+                    type_size(type) * values,
+                    column_stride, row_stride, frame_stride};
+            }
+
+            // Fills in packed strides for a width x height image
+            RangefinderOutput resolve(const int width, const int height) const
+            {
+                auto resolved = *this;
+
+                for (auto channel : {&resolved.distance, &resolved.point,
+                        &resolved.wall, &resolved.validity}) {
+
+                    if (channel->column_stride == 0) {
+                        channel->column_stride = channel->item_size;
+                    }
+                    if (channel->row_stride == 0) {
+                        channel->row_stride = channel->column_stride * width;
+                    }
+                    if (channel->frame_stride == 0) {
+                        channel->frame_stride = channel->row_stride * height;
+                    }
+                }
+
+                return resolved;
+            }
+
+            static char * address(const channel_t & channel,
+                    const size_t frame, const int x, const int y)
+            {
+                return channel.data + (ptrdiff_t)frame * channel.frame_stride +
+                    y * channel.row_stride + x * channel.column_stride;
+            }
+
+            static void store(char * address, const type_t type,
+                    const double value)
+            {
+                switch (type) {
+                    case TYPE_INT32:
+                        *(int32_t *)address = (int32_t)value;
+                        break;
+                    case TYPE_UINT8:
+                        *(uint8_t *)address = value <= 0 ? 0 :
+                            value >= UINT8_MAX ? UINT8_MAX : (uint8_t)value;
+                        break;
+                    case TYPE_UINT16:
+                        *(uint16_t *)address = value <= 0 ? 0 :
+                            value >= UINT16_MAX ? UINT16_MAX : (uint16_t)value;
+                        break;
+                    case TYPE_FLOAT32:
+                        *(float *)address = (float)value;
+                        break;
+                    default:
+                        *(double *)address = value;
+                }
+            }
+
+            bool wants_points() const
+            {
+                return point.data != nullptr;
+            }
+
+            // Writes one pixel of every requested channel.  The distance has
+            // had the sensor's offset subtracted and is INFINITY if the beam
+            // hit nothing within range.
+            void write(const size_t frame, const int x, const int y,
+                    const double dist, const int wall_index,
+                    const vec3_t & hit_point) const
+            {
+                const auto hit = dist != INFINITY;
+
+                if (distance.data) {
+
+                    const auto scaled =
+                        unit == UNIT_MILLIMETERS ? dist * 1000 : dist;
+
+                    store(address(distance, frame, x, y), distance.type,
+                            hit ? scaled :
+                            distance.type == TYPE_INT32 ? -1 :
+                            distance.type == TYPE_FLOAT32 ||
+                            distance.type == TYPE_FLOAT64 ? NAN : 0);
+                }
+
+                if (point.data) {
+
+                    auto p = address(point, frame, x, y);
+                    const auto size = type_size(point.type);
+
+                    store(p, point.type, hit ? hit_point.x : NAN);
+                    store(p + size, point.type, hit ? hit_point.y : NAN);
+                    store(p + 2 * size, point.type, hit ? hit_point.z : NAN);
+                }
+
+                if (wall.data) {
+                    *(int32_t *)address(wall, frame, x, y) =
+                        hit ? wall_index : -1;
+                }
+
+                if (validity.data) {
+                    *(uint8_t *)address(validity, frame, x, y) = hit;
+                }
+            }
+    };
+
+}
@@ -18,10 +18,18 @@
 
 #pragma once
 
+#include <string.h>
+
+#include <type_traits>
 #include <vector>
 using namespace std;
 
 #include <simsensors/src/math.hpp>
+#include <simsensors/src/profiler.hpp>
+#include <simsensors/src/sensors/noise.hpp>
+#include <simsensors/src/sensors/output.hpp>
+#include <simsensors/src/threadpool.hpp>
+#include <simsensors/src/world.hpp>
 
 namespace simsens {
 
@@ -34,15 +42,117 @@ namespace simsens {
             double min_distance_m;
             double max_distance_m;
 
+            // Noise added to every read; none unless the robot file gives
+            // some or the caller sets it
+            RangefinderNoise noise;
+
+            Rangefinder()
+            {
+                width = 0;
+                height = 0;
+                min_distance_m = 0;
+                max_distance_m = 0;
+                field_of_view_radians = 0;
+                translation = {};
+                rotation = {};
+                memset(name, 0, sizeof(name));
+                pool = nullptr;
+                coherent = false;
+                have_last_pose = false;
+                max_jump_m = 0;
+                max_jump_rad = 0;
+                last_pose = {};
+                mounting_angles = {};
+                offset_m = 0;
+            }
+
+            // Fills a width x height depth image, row by row.  With T=float
+            // the walls are tested in single precision, twice as many per
+            // SIMD instruction, to within about a millimeter of the double
+            // result (see examples/accuracy).  Coherent mode applies only to
+            // double reads.
+            template <typename T=double>
             void read(const pose_t & robot_pose, World & world,
                     int * distances_mm)
             {
-                const auto robpose = world.adjust_pose(robot_pose);
+                read<T>(robot_pose, world,
+                        RangefinderOutput().distances(distances_mm));
+            }
 
-                for (int k=0; k<this->width; ++k) {
+            // Writes each channel requested by the output in the same pass
+            template <typename T=double>
+            void read(const pose_t & robot_pose, World & world,
+                    const RangefinderOutput & output)
+            {
+                read_adjusted<T>(world.adjust_pose(robot_pose), world, output);
+            }
 
-                    distances_mm[k] = distance_on_beam(robpose, world.walls, k);
-                }
+            // Fills one width x height image per pose, consecutively
+            template <typename T=double>
+            void read_batch(const pose_t * robot_poses, const size_t count,
+                    World & world, int * distances_mm)
+            {
+                read_batch<T>(robot_poses, count, world,
+                        RangefinderOutput().distances(distances_mm));
+            }
+
+            // Writes one frame of each requested channel per pose
+            template <typename T=double>
+            void read_batch(const pose_t * robot_poses, const size_t count,
+                    World & world, const RangefinderOutput & output)
+            {
+                SIMSENS_SCOPE(SCOPE_READ_BATCH);
+
+                const size_t frame_size = width * height;
+
+                const auto resolved = output.resolve(width, height);
+
+                // Pose k gets scan number first_scan + k wherever it runs
+                const auto first_scan = noise.scan;
+                noise.scan += count;
+
+                get_pool().parallel_for(count,
+                        (INTS_PER_CACHE_LINE + frame_size - 1) / frame_size,
+                        frame_size * world.obstacle_count(),
+                        [&](const size_t begin, const size_t end) {
+                        vector<float> samples(
+                                noise.enabled() ? 2 * frame_size : 0);
+                        visible_t visible;
+                        for (size_t k=begin; k<end; ++k) {
+                            if (noise.enabled()) {
+                                noise.generate(first_scan + k, frame_size,
+                                        samples.data());
+                            }
+                            const auto robpose =
+                                world.adjust_pose(robot_poses[k]);
+                            cull_walls<T>(robpose, world, max_distance_m,
+                                    visible);
+                            read_frame<T>(robpose, world, visible, resolved,
+                                    k, 0, width,
+                                    noise.enabled() ? samples.data() : nullptr);
+                        }
+                        });
+            }
+            // In coherent mode, read() remembers the wall each beam hit and
+            // tests it first on the next read, skipping walls that cannot be
+            // nearer.  Results are unchanged.  A pose that jumps farther
+            // than the given limits since the last read gets a full search.
+            // Not used by read_batch(), whose poses are unrelated.
+            void use_coherence(const bool enable,
+                    const double max_jump_m=0.1,
+                    const double max_jump_rad=0.2)
+            {
+                coherent = enable;
+                this->max_jump_m = max_jump_m;
+                this->max_jump_rad = max_jump_rad;
+                have_last_pose = false;
+                last_walls.clear();
+            }
+
+            // Runs reads on the given pool instead of the shared one
+            void use_thread_pool(ThreadPool & pool)
+            {
+                this->pool = &pool;
             }
 
             void dump()
@@ -68,53 +178,422 @@ namespace simsens {
             rotation_t rotation;
             char name[100];
 
-            int distance_on_beam(
-                    const pose_t & robot_pose,
-                    const vector<Wall *> walls,
-                    const int beam_index)
+            // Beam directions relative to the sensor's center, in image
+            // order: each column's azimuth as a unit vector, and each row's
+            // elevation as a tangent
+            vector<direction_t> column_directions;
+            vector<double> row_elevation_tans;
+
+            // One read's normal samples, then its uniform samples
+            vector<float> noise_samples;
+
+            // Reads from a pose the world has already adjusted, so that
+            // sensors sharing a pose can share the adjustment
+            template <typename T>
+            void read_adjusted(const pose_t & robpose, const World & world,
+                    const RangefinderOutput & output)
+            {
+                SIMSENS_SCOPE(SCOPE_READ);
+
+                const auto remember = coherent && is_same<T, double>::value;
+
+                double seed_radius = INFINITY;
+
+                const auto seeded = remember && prepare_seeds(
+                        robpose, world, seed_radius);
+
+                cull_walls<T>(robpose, world,
+                        min(max_distance_m, seed_radius), visible);
+
+                const auto resolved = output.resolve(width, height);
+
+                // Draw the whole image's noise up front, so that splitting
+                // the columns among threads can't change it
+                const float * samples = nullptr;
+                if (noise.enabled()) {
+                    noise_samples.resize(2 * width * height);
+                    noise.generate(noise.scan++, width * height,
+                            noise_samples.data());
+                    samples = noise_samples.data();
+                }
+
+                // Split the columns so that each chunk writes whole cache
+                // lines of every row
+                get_pool().parallel_for(width, INTS_PER_CACHE_LINE,
+                        height * world.obstacle_count(),
+                        [&](const size_t begin, const size_t end) {
+                        read_frame<T>(robpose, world, visible, resolved, 0,
+                                begin, end, samples, remember, seeded);
+                        });
+
+                last_pose = robpose;
+                have_last_pose = true;
+            }
+
+            // The sensor's rotation w.r.t. the vehicle, and its offset,
+            // subtracted from every distance
+            vec3_t mounting_angles;
+            double offset_m;
+
+            // Called by the parser once the sensor's specs are known
+            void build_beam_angles()
             {
-                // Get rangefinder rotation w.r.t. vehicle
-                vec3_t rangefinder_angles= {};
-                rotation_to_euler(rotation, rangefinder_angles);
+                rotation_to_euler(rotation, mounting_angles);
+
+                offset_m = sqrt(
+                        sqr(translation.x) +
+                        sqr(translation.y) +
+                        sqr(translation.z));
+
+                column_directions.resize(width);
+
+                for (int x=0; x<width; ++x) {
+                    const auto azimuth = width == 1 ? 0 :
+                        (x / (width - 1.) - 0.5) * field_of_view_radians;
+                    column_directions[x] =
+                        direction_t {cos(azimuth), sin(azimuth)};
+                }
+
+                // Webots derives the vertical field of view from the
+                // horizontal one and the image's aspect ratio
+                const auto vertical_fov = 2 * atan(
+                        tan(field_of_view_radians / 2) * height / width);
+
+                row_elevation_tans.resize(height);
+
+                for (int y=0; y<height; ++y) {
+                    row_elevation_tans[y] = height == 1 ? 0 :
+                        tan((y / (height - 1.) - 0.5) * vertical_fov);
+                }
+            }
+
+            static constexpr size_t INTS_PER_CACHE_LINE = 64 / sizeof(int);
+
+            ThreadPool * pool;
+
+            ThreadPool & get_pool()
+            {
+                return pool ? *pool : ThreadPool::shared();
+            }
+
+            // Coherent-mode state: the wall each beam hit last time, and
+            // this read's distance to it
+            bool coherent;
+            double max_jump_m;
+            double max_jump_rad;
+            bool have_last_pose;
+            pose_t last_pose;
+            vector<size_t> last_walls;
+            vector<double> seeds;
+
+            // The walls one read could hit, with their indices in the
+            // world, when the world has no spatial index to find them
+            typedef struct {
+                bool culled;
+                WallSegments segments;
+                BasicWallSegments<float> float_segments;
+                vector<size_t> indices;
+            } visible_t;
+
+            visible_t visible;
+
+            static constexpr double BOUND_TOLERANCE_M = 1e-9;
+            static constexpr double BOUND_TOLERANCE_RAD = 1e-9;
+
+            // How far in XY a beam has to reach to find every hit within
+            // range: a wall's reported distance is less its half-thickness
+            double reach_m(const World & world) const
+            {
+                return max_distance_m + world.segments.max_half_thickness +
+                    BOUND_TOLERANCE_M;
+            }
+
+            // Gathers the walls that some beam from the pose could hit
+            // within the given distance: those near enough, and inside the
+            // sensor's horizontal field of view.  A spatial index already
+            // confines a search to the walls near each beam, so with one the
+            // whole world is left in play.
+            template <typename T>
+            void cull_walls(const pose_t & robpose, const World & world,
+                    const double radius, visible_t & visible) const
+            {
+                visible.culled = world.accelerator == ACCELERATOR_NONE;
+
+                if (!visible.culled) {
+                    return;
+                }
+
+                visible.segments.clear();
+                visible.indices.clear();
+
+                const auto & segments = world.segments;
+
+                const auto azimuth = robpose.psi + mounting_angles.z;
+                const auto ca = cos(azimuth);
+                const auto sa = sin(azimuth);
 
-                const double azimuth =
-                    robot_pose.psi + rangefinder_angles.z + 
-                    (beam_index / (width - 1.) - 0.5) * field_of_view_radians;
+                const auto half_fov = width > 1 ? field_of_view_radians / 2 : 0;
 
-                const double elevation = robot_pose.theta + rangefinder_angles.y; 
+                for (size_t k=0; k<segments.count; ++k) {
+
+                    const auto ht = segments.half_thickness[k];
+
+                    const auto dist = segments.centerline_distance(
+                            k, robpose.x, robpose.y);
+
+                    // A wall's reported distance is at least its
+                    // centerline's distance less its half-thickness
+                    if (dist - ht > radius + BOUND_TOLERANCE_M) {
+                        continue;
+                    }
+
+                    // A wall the sensor is inside of could be hit by any
+                    // beam
+                    if (dist > ht) {
+
+                        // Bearings of the centerline's ends from the
+                        // sensor's heading, positive toward higher columns
+                        const auto px = segments.x3[k] - robpose.x;
+                        const auto py = segments.y3[k] - robpose.y;
+                        const auto qx = px + segments.ex[k];
+                        const auto qy = py + segments.ey[k];
+
+                        const auto bp = atan2(-px * sa - py * ca,
+                                px * ca - py * sa);
+                        const auto bq = atan2(-qx * sa - qy * ca,
+                                qx * ca - qy * sa);
+
+                        // The centerline spans less than half a turn, and
+                        // its thickness widens that by at most asin(ht/dist)
+                        const auto span = remainder(bq - bp, 2 * M_PI);
+
+                        if (fabs(remainder(bp + span / 2, 2 * M_PI)) >
+                                half_fov + fabs(span) / 2 + asin(ht / dist) +
+                                BOUND_TOLERANCE_RAD) {
+                            continue;
+                        }
+                    }
+
+                    visible.segments.append(segments, k);
+                    visible.indices.push_back(k);
+                }
+
+                SIMSENS_COUNT(COUNTER_CULLED_WALLS,
+                        segments.count - visible.indices.size());
+
+                if constexpr (is_same<T, float>::value) {
+                    visible.float_segments.assign(visible.segments);
+                }
+            }
+
+            // Tests each beam against its last obstacle and returns false
+            // if there is nothing to go on and the read should search every
+            // wall.  The radius comes back as the farthest seed, beyond
+            // which no wall can beat every beam's seed, or INFINITY if some
+            // beam has none.
+            bool prepare_seeds(
+                    const pose_t & robpose,
+                    const World & world,
+                    double & radius)
+            {
+                const size_t frame_size = width * height;
+
+                const auto jumped = !have_last_pose ||
+                    sqrt(sqr(robpose.x - last_pose.x) +
+                            sqr(robpose.y - last_pose.y) +
+                            sqr(robpose.z - last_pose.z)) > max_jump_m ||
+                    fabs(robpose.psi - last_pose.psi) > max_jump_rad ||
+                    fabs(robpose.theta - last_pose.theta) > max_jump_rad;
+
+                if (jumped || last_walls.size() != frame_size) {
+                    last_walls.assign(frame_size, World::NO_OBSTACLE);
+                    return false;
+                }
+
+                seeds.resize(frame_size);
+
+                radius = 0;
+
+                for_each_beam(robpose, mounting_angles, 0, width,
+                        reach_m(world),
+                        [&](const beam_t & beam, const int x, const int y) {
+                        const auto pixel = y * width + x;
+                        const auto k = last_walls[pixel];
+                        seeds[pixel] = k != World::NO_OBSTACLE ?
+                        world.obstacle_distance(beam, k) : INFINITY;
+                        radius = max(radius, seeds[pixel]);
+                        });
+
+                return true;
+            }
+
+            // Calls fn(beam, x, y) for every pixel in columns
+            // [x_begin, x_end) of the image, with beams reaching the given
+            // distance in XY
+            template <typename F>
+            void for_each_beam(
+                    const pose_t & robpose,
+                    const vec3_t & rangefinder_angles,
+                    const size_t x_begin,
+                    const size_t x_end,
+                    const double reach,
+                    F fn)
+            {
+                const double azimuth = robpose.psi + rangefinder_angles.z;
+
+                const double elevation = robpose.theta + rangefinder_angles.y; 
 
                 const vec3_t location =
-                    vec3_t{robot_pose.x, robot_pose.y, robot_pose.z};
+                    vec3_t{robpose.x, robpose.y, robpose.z};
+
+                const auto tan_elevation = tan(elevation);
+
+                // The read's only trigonometry: each column's direction is
+                // the table's, rotated by the sensor's heading
+                const direction_t heading = {cos(azimuth), sin(azimuth)};
+
+                for (size_t x=x_begin; x<x_end; ++x) {
+
+                    const auto & column = column_directions[x];
+
+                    auto beam = make_beam(location,
+                            heading.c * column.c - heading.s * column.s,
+                            heading.s * column.c + heading.c * column.s,
+                            reach);
+
+                    // Only the elevation changes down a column, so we reuse
+                    // the beam and combine the tangents of the two angles
+                    for (int y=0; y<height; ++y) {
 
-                // Run a classic calculate-min loop to get distance to closest wall
-                double dist = INFINITY;
-                vec3_t intersection = {};
-                for (auto wall : walls) {
-                    const auto newdist = intersect_with_wall(
-                            location, azimuth, elevation, *wall,
-                            &intersection);
+                        const auto t = row_elevation_tans[y];
 
-                    dist = min(dist, newdist);
+                        beam.tan_elevation =
+                            (tan_elevation + t) / (1 - tan_elevation * t);
+
+                        fn(beam, x, y);
+                    }
+                }
+            }
+
+            // Fills columns [x_begin, x_end) of one frame of the output,
+            // adding noise from the frame's samples if there are any
+            template <typename T>
+            void read_frame(
+                    const pose_t & robpose,
+                    const World & world,
+                    const visible_t & visible,
+                    const RangefinderOutput & output,
+                    const size_t frame,
+                    const size_t x_begin,
+                    const size_t x_end,
+                    const float * samples,
+                    const bool remember=false,
+                    const bool seeded=false)
+            {
+                for_each_beam(robpose, mounting_angles, x_begin, x_end,
+                        reach_m(world),
+                        [&](const beam_t & beam, const int x, const int y) {
+
+                        const auto pixel = y * width + x;
+                        const auto test_beam = beam_cast<T>(beam);
+
+                        size_t wall_index = seeded ? last_walls[pixel] : 0;
+
+                        const auto dist = seeded ?
+                        nearest_visible(beam, world, visible, wall_index,
+                                seeds[pixel]) :
+                        nearest_visible(test_beam, world, visible, wall_index);
+
+                        if (remember) {
+                            last_walls[pixel] = wall_index;
+                        }
+
+                        SIMSENS_COUNT(COUNTER_BEAMS, 1);
+                        SIMSENS_COUNT(COUNTER_HITS, dist < INFINITY);
+
+                        // Only the obstacle's index comes back from the
+                        // search, so find where the beam hit it again if
+                        // asked
+                        vec3_t hit_point = {};
+                        if (output.wants_points() && dist < INFINITY) {
+                            world.obstacle_distance(test_beam, wall_index,
+                                    &hit_point);
+                            hit_point.y = world.yinvert(hit_point.y);
+                        }
+
+                        auto measured = measured_distance(dist);
+
+                        if (samples) {
+                            measured = noise.apply(measured, samples[pixel],
+                                    samples[width * height + pixel]);
+                        }
+
+                        output.write(frame, x, y, measured, wall_index,
+                                hit_point);
+                        });
+            }
+
+            // Nearest obstacle on the beam among the read's visible walls
+            // and the world's other obstacles.  A finite seed is a known hit
+            // on the obstacle passed in index.
+            template <typename T>
+            static T nearest_visible(
+                    const basic_beam_t<T> & beam,
+                    const World & world,
+                    const visible_t & visible,
+                    size_t & index,
+                    const T seed=INFINITY)
+            {
+                if (!visible.culled) {
+                    return world.nearest_wall(beam, index, seed);
+                }
+
+                const auto & segments = visible_segments<T>(visible);
+
+                size_t k = 0;
+                auto dist = nearest_segment_on_beam(beam, segments, k);
+
+                const auto seed_index = index;
+
+                index = k < segments.count ?
+                    visible.indices[k] : world.segments.count;
+
+                reduce_nearest(seed, seed_index, dist, index);
+
+                world.nearest_primitive(beam, dist, index);
+
+                return dist;
+            }
+
+            template <typename T>
+            static const BasicWallSegments<T> & visible_segments(
+                    const visible_t & visible)
+            {
+                if constexpr (is_same<T, float>::value) {
+                    return visible.float_segments;
                 }
+                else {
+                    return visible.segments;
+                }
+            }
 
+            // Distance as the sensor reports it: cut off at its maximum
+            // range, less its offset
+            double measured_distance(double dist)
+            {
                 // Cut off distance at rangefinder's maximum
                 if (dist > max_distance_m) {
                     dist = INFINITY;
-                    //if (dbg_intersection!=nullptr) {
-                    //    dbg_intersection->z = -1;
-                    //}
                 }
 
                 // Subtract sensor offset from distance
-                dist -= sqrt(
-                        sqr(this->translation.x) +
-                        sqr(this->translation.y) +
-                        sqr(this->translation.z));
-
-                return dist == INFINITY ? -1 : dist * 1000;
+                return dist - offset_m;
             }
 
+            friend class Robot;
+            friend class ScanLogWriter;
             friend class RangefinderVisualizer;
             friend class RobotParser;
+            friend class RobotCache;
     };
 }
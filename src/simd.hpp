@@ -0,0 +1,447 @@
+/*
+   Vectorized beam-versus-wall kernel
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(SIMSENS_NO_SIMD) && defined(__AVX2__)
+#define SIMSENS_AVX2
+#include <immintrin.h>
+#elif !defined(SIMSENS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#define SIMSENS_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <simsensors/src/math.hpp>
+#include <simsensors/src/profiler.hpp>
+#include <simsensors/src/obstacles/segments.hpp>
+
+namespace simsens {
+
+    // Keeps the nearest distance, breaking ties in favor of the lower index
+    // so that the result does not depend on the lane width
+    template <typename T>
+    static void reduce_nearest(
+            const T newdist, const size_t newindex,
+            T & dist, size_t & index)
+    {
+        if (newdist < dist || (newdist == dist && newdist < INFINITY &&
+                    newindex < index)) {
+            dist = newdist;
+            index = newindex;
+        }
+    }
+
+    // Tests one beam against several cached wall segments at once (four with
+    // AVX2, two pairs of two with SSE2) and reduces to the nearest hit
+    // without branching.  The instruction set is chosen at compile time from
+    // the compiler's target flags (e.g. -mavx2); define SIMSENS_NO_SIMD to
+    // force the scalar path.
+    //
+    // Each lane performs the same IEEE operations, in the same order, as
+    // intersect_with_segment(), so the two normally agree exactly.  If the
+    // compiler contracts the scalar path into fused multiply-adds (e.g.
+    // -march=native), distances can differ by a few ulps -- well under 1e-9 m
+    // -- which can move a reported millimeter by at most one.  The same
+    // bound holds against the original per-beam wall test, which does the
+    // trigonometry the cached segments save; examples/kernels checks each
+    // instruction set's kernel against it.
+    //
+    // Returns the distance to the nearest wall hit by the beam, or INFINITY
+    // if there is none; index is set to the lowest index of the nearest wall.
+    // Inline so that programs that never read a rangefinder don't warn
+    // about it.
+    static inline double nearest_segment_on_beam(
+            const beam_t & beam,
+            const WallSegments & segments,
+            size_t & index)
+    {
+        double dist = INFINITY;
+        index = segments.count;
+
+        SIMSENS_COUNT(COUNTER_RAY_TESTS, segments.count);
+
+        size_t k = 0;
+
+#if defined(SIMSENS_AVX2)
+
+        const auto x1 = _mm256_set1_pd(beam.x1);
+        const auto y1 = _mm256_set1_pd(beam.y1);
+        const auto bdx = _mm256_set1_pd(beam.dx);
+        const auto bdy = _mm256_set1_pd(beam.dy);
+        const auto bz = _mm256_set1_pd(beam.z);
+        const auto neg_tan = _mm256_set1_pd(-beam.tan_elevation);
+        const auto zero = _mm256_setzero_pd();
+        const auto one = _mm256_set1_pd(1);
+        const auto inf = _mm256_set1_pd(INFINITY);
+        const auto four = _mm256_set1_pd(4);
+
+        auto best = inf;
+        auto best_index = _mm256_set_pd(3, 2, 1, 0);
+        auto lane_index = best_index;
+
+        for (; k + 4 <= segments.count; k += 4) {
+
+            const auto x3 = _mm256_loadu_pd(&segments.x3[k]);
+            const auto y3 = _mm256_loadu_pd(&segments.y3[k]);
+            const auto ex = _mm256_loadu_pd(&segments.ex[k]);
+            const auto ey = _mm256_loadu_pd(&segments.ey[k]);
+
+            const auto denom = _mm256_sub_pd(
+                    _mm256_mul_pd(ey, bdx), _mm256_mul_pd(ex, bdy));
+
+            const auto y13 = _mm256_sub_pd(y1, y3);
+            const auto x13 = _mm256_sub_pd(x1, x3);
+
+            const auto ua = _mm256_div_pd(_mm256_sub_pd(
+                        _mm256_mul_pd(ex, y13), _mm256_mul_pd(ey, x13)), denom);
+            const auto ub = _mm256_div_pd(_mm256_sub_pd(
+                        _mm256_mul_pd(bdx, y13), _mm256_mul_pd(bdy, x13)), denom);
+
+            auto hit = _mm256_cmp_pd(denom, zero, _CMP_NEQ_OQ);
+            hit = _mm256_and_pd(hit, _mm256_cmp_pd(ua, zero, _CMP_GE_OQ));
+            hit = _mm256_and_pd(hit, _mm256_cmp_pd(ua, one, _CMP_LE_OQ));
+            hit = _mm256_and_pd(hit, _mm256_cmp_pd(ub, zero, _CMP_GE_OQ));
+            hit = _mm256_and_pd(hit, _mm256_cmp_pd(ub, one, _CMP_LE_OQ));
+
+            const auto px = _mm256_add_pd(x1, _mm256_mul_pd(ua, bdx));
+            const auto py = _mm256_add_pd(y1, _mm256_mul_pd(ua, bdy));
+            const auto dx = _mm256_sub_pd(x1, px);
+            const auto dy = _mm256_sub_pd(y1, py);
+            const auto xy2 = _mm256_add_pd(
+                    _mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+            const auto dz = _mm256_mul_pd(neg_tan, _mm256_sqrt_pd(xy2));
+            const auto xyzdist = _mm256_sub_pd(
+                    _mm256_sqrt_pd(_mm256_add_pd(xy2, _mm256_mul_pd(dz, dz))),
+                    _mm256_loadu_pd(&segments.half_thickness[k]));
+            const auto pz = _mm256_add_pd(bz, dz);
+
+            hit = _mm256_and_pd(hit, _mm256_cmp_pd(pz,
+                        _mm256_loadu_pd(&segments.height[k]), _CMP_LT_OQ));
+
+            const auto d = _mm256_blendv_pd(inf, xyzdist, hit);
+            const auto closer = _mm256_cmp_pd(d, best, _CMP_LT_OQ);
+
+            best = _mm256_blendv_pd(best, d, closer);
+            best_index = _mm256_blendv_pd(best_index, lane_index, closer);
+            lane_index = _mm256_add_pd(lane_index, four);
+        }
+
+        double lane_best[4] = {};
+        double lane_best_index[4] = {};
+        _mm256_storeu_pd(lane_best, best);
+        _mm256_storeu_pd(lane_best_index, best_index);
+
+        for (int j=0; j<4; ++j) {
+            reduce_nearest(lane_best[j], (size_t)lane_best_index[j],
+                    dist, index);
+        }
+
+#elif defined(SIMSENS_SSE2)
+
+        const auto x1 = _mm_set1_pd(beam.x1);
+        const auto y1 = _mm_set1_pd(beam.y1);
+        const auto bdx = _mm_set1_pd(beam.dx);
+        const auto bdy = _mm_set1_pd(beam.dy);
+        const auto bz = _mm_set1_pd(beam.z);
+        const auto neg_tan = _mm_set1_pd(-beam.tan_elevation);
+        const auto zero = _mm_setzero_pd();
+        const auto one = _mm_set1_pd(1);
+        const auto inf = _mm_set1_pd(INFINITY);
+        const auto four = _mm_set1_pd(4);
+
+        // Distances to walls j and j+1, INFINITY for a miss
+        auto pair = [&](const size_t j) {
+
+            const auto x3 = _mm_loadu_pd(&segments.x3[j]);
+            const auto y3 = _mm_loadu_pd(&segments.y3[j]);
+            const auto ex = _mm_loadu_pd(&segments.ex[j]);
+            const auto ey = _mm_loadu_pd(&segments.ey[j]);
+
+            const auto denom = _mm_sub_pd(
+                    _mm_mul_pd(ey, bdx), _mm_mul_pd(ex, bdy));
+
+            const auto y13 = _mm_sub_pd(y1, y3);
+            const auto x13 = _mm_sub_pd(x1, x3);
+
+            const auto ua = _mm_div_pd(_mm_sub_pd(
+                        _mm_mul_pd(ex, y13), _mm_mul_pd(ey, x13)), denom);
+            const auto ub = _mm_div_pd(_mm_sub_pd(
+                        _mm_mul_pd(bdx, y13), _mm_mul_pd(bdy, x13)), denom);
+
+            auto hit = _mm_cmpneq_pd(denom, zero);
+            hit = _mm_and_pd(hit, _mm_cmpge_pd(ua, zero));
+            hit = _mm_and_pd(hit, _mm_cmple_pd(ua, one));
+            hit = _mm_and_pd(hit, _mm_cmpge_pd(ub, zero));
+            hit = _mm_and_pd(hit, _mm_cmple_pd(ub, one));
+
+            const auto px = _mm_add_pd(x1, _mm_mul_pd(ua, bdx));
+            const auto py = _mm_add_pd(y1, _mm_mul_pd(ua, bdy));
+            const auto dx = _mm_sub_pd(x1, px);
+            const auto dy = _mm_sub_pd(y1, py);
+            const auto xy2 = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+            const auto dz = _mm_mul_pd(neg_tan, _mm_sqrt_pd(xy2));
+            const auto xyzdist = _mm_sub_pd(
+                    _mm_sqrt_pd(_mm_add_pd(xy2, _mm_mul_pd(dz, dz))),
+                    _mm_loadu_pd(&segments.half_thickness[j]));
+            const auto pz = _mm_add_pd(bz, dz);
+
+            hit = _mm_and_pd(hit, _mm_cmplt_pd(pz,
+                        _mm_loadu_pd(&segments.height[j])));
+
+            // SSE2 has no blend, so select with and/andnot/or
+            return _mm_or_pd(_mm_and_pd(hit, xyzdist),
+                    _mm_andnot_pd(hit, inf));
+        };
+
+        auto keep = [](const __m128d d, const __m128d lane_index,
+                __m128d & best, __m128d & best_index) {
+
+            const auto closer = _mm_cmplt_pd(d, best);
+
+            best = _mm_or_pd(_mm_and_pd(closer, d),
+                    _mm_andnot_pd(closer, best));
+            best_index = _mm_or_pd(_mm_and_pd(closer, lane_index),
+                    _mm_andnot_pd(closer, best_index));
+        };
+
+        // Two pairs per iteration, so that each pair's divisions and
+        // square roots overlap the other's
+        auto best_lo = inf;
+        auto best_hi = inf;
+        auto best_index_lo = _mm_set_pd(1, 0);
+        auto best_index_hi = _mm_set_pd(3, 2);
+        auto lane_index_lo = best_index_lo;
+        auto lane_index_hi = best_index_hi;
+
+        for (; k + 4 <= segments.count; k += 4) {
+
+            const auto d_lo = pair(k);
+            const auto d_hi = pair(k + 2);
+
+            keep(d_lo, lane_index_lo, best_lo, best_index_lo);
+            keep(d_hi, lane_index_hi, best_hi, best_index_hi);
+
+            lane_index_lo = _mm_add_pd(lane_index_lo, four);
+            lane_index_hi = _mm_add_pd(lane_index_hi, four);
+        }
+
+        double lane_best[4] = {};
+        double lane_best_index[4] = {};
+        _mm_storeu_pd(lane_best, best_lo);
+        _mm_storeu_pd(lane_best + 2, best_hi);
+        _mm_storeu_pd(lane_best_index, best_index_lo);
+        _mm_storeu_pd(lane_best_index + 2, best_index_hi);
+
+        for (int j=0; j<4; ++j) {
+            reduce_nearest(lane_best[j], (size_t)lane_best_index[j],
+                    dist, index);
+        }
+
+#endif
+
+        // Scalar fallback, and leftover walls from the vector loop
+        for (; k<segments.count; ++k) {
+            reduce_nearest(intersect_with_segment(beam, segments, k), k,
+                    dist, index);
+        }
+
+        return dist;
+    }
+
+    // Single-precision version of the above, testing twice as many walls at
+    // once (eight with AVX2, four with SSE2).  Lane indices are kept as
+    // integers, so they stay exact for any number of walls.  Inline for the
+    // same reason.
+    static inline float nearest_segment_on_beam(
+            const basic_beam_t<float> & beam,
+            const BasicWallSegments<float> & segments,
+            size_t & index)
+    {
+        float dist = INFINITY;
+        index = segments.count;
+
+        SIMSENS_COUNT(COUNTER_RAY_TESTS, segments.count);
+
+        size_t k = 0;
+
+#if defined(SIMSENS_AVX2)
+
+        const auto x1 = _mm256_set1_ps(beam.x1);
+        const auto y1 = _mm256_set1_ps(beam.y1);
+        const auto bdx = _mm256_set1_ps(beam.dx);
+        const auto bdy = _mm256_set1_ps(beam.dy);
+        const auto bz = _mm256_set1_ps(beam.z);
+        const auto neg_tan = _mm256_set1_ps(-beam.tan_elevation);
+        const auto zero = _mm256_setzero_ps();
+        const auto one = _mm256_set1_ps(1);
+        const auto inf = _mm256_set1_ps(INFINITY);
+        const auto eight = _mm256_set1_epi32(8);
+
+        auto best = inf;
+        auto best_index = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+        auto lane_index = best_index;
+
+        for (; k + 8 <= segments.count; k += 8) {
+
+            const auto x3 = _mm256_loadu_ps(&segments.x3[k]);
+            const auto y3 = _mm256_loadu_ps(&segments.y3[k]);
+            const auto ex = _mm256_loadu_ps(&segments.ex[k]);
+            const auto ey = _mm256_loadu_ps(&segments.ey[k]);
+
+            const auto denom = _mm256_sub_ps(
+                    _mm256_mul_ps(ey, bdx), _mm256_mul_ps(ex, bdy));
+
+            const auto y13 = _mm256_sub_ps(y1, y3);
+            const auto x13 = _mm256_sub_ps(x1, x3);
+
+            const auto ua = _mm256_div_ps(_mm256_sub_ps(
+                        _mm256_mul_ps(ex, y13), _mm256_mul_ps(ey, x13)), denom);
+            const auto ub = _mm256_div_ps(_mm256_sub_ps(
+                        _mm256_mul_ps(bdx, y13), _mm256_mul_ps(bdy, x13)), denom);
+
+            auto hit = _mm256_cmp_ps(denom, zero, _CMP_NEQ_OQ);
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(ua, zero, _CMP_GE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(ua, one, _CMP_LE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(ub, zero, _CMP_GE_OQ));
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(ub, one, _CMP_LE_OQ));
+
+            const auto px = _mm256_add_ps(x1, _mm256_mul_ps(ua, bdx));
+            const auto py = _mm256_add_ps(y1, _mm256_mul_ps(ua, bdy));
+            const auto dx = _mm256_sub_ps(x1, px);
+            const auto dy = _mm256_sub_ps(y1, py);
+            const auto xy2 = _mm256_add_ps(
+                    _mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            const auto dz = _mm256_mul_ps(neg_tan, _mm256_sqrt_ps(xy2));
+            const auto xyzdist = _mm256_sub_ps(
+                    _mm256_sqrt_ps(_mm256_add_ps(xy2, _mm256_mul_ps(dz, dz))),
+                    _mm256_loadu_ps(&segments.half_thickness[k]));
+            const auto pz = _mm256_add_ps(bz, dz);
+
+            hit = _mm256_and_ps(hit, _mm256_cmp_ps(pz,
+                        _mm256_loadu_ps(&segments.height[k]), _CMP_LT_OQ));
+
+            const auto d = _mm256_blendv_ps(inf, xyzdist, hit);
+            const auto closer = _mm256_cmp_ps(d, best, _CMP_LT_OQ);
+
+            best = _mm256_blendv_ps(best, d, closer);
+            best_index = _mm256_blendv_epi8(best_index, lane_index,
+                    _mm256_castps_si256(closer));
+            lane_index = _mm256_add_epi32(lane_index, eight);
+        }
+
+        float lane_best[8] = {};
+        uint32_t lane_best_index[8] = {};
+        _mm256_storeu_ps(lane_best, best);
+        _mm256_storeu_si256((__m256i *)lane_best_index, best_index);
+
+        for (int j=0; j<8; ++j) {
+            reduce_nearest(lane_best[j], (size_t)lane_best_index[j],
+                    dist, index);
+        }
+
+#elif defined(SIMSENS_SSE2)
+
+        const auto x1 = _mm_set1_ps(beam.x1);
+        const auto y1 = _mm_set1_ps(beam.y1);
+        const auto bdx = _mm_set1_ps(beam.dx);
+        const auto bdy = _mm_set1_ps(beam.dy);
+        const auto bz = _mm_set1_ps(beam.z);
+        const auto neg_tan = _mm_set1_ps(-beam.tan_elevation);
+        const auto zero = _mm_setzero_ps();
+        const auto one = _mm_set1_ps(1);
+        const auto inf = _mm_set1_ps(INFINITY);
+        const auto four = _mm_set1_epi32(4);
+
+        auto best = inf;
+        auto best_index = _mm_set_epi32(3, 2, 1, 0);
+        auto lane_index = best_index;
+
+        for (; k + 4 <= segments.count; k += 4) {
+
+            const auto x3 = _mm_loadu_ps(&segments.x3[k]);
+            const auto y3 = _mm_loadu_ps(&segments.y3[k]);
+            const auto ex = _mm_loadu_ps(&segments.ex[k]);
+            const auto ey = _mm_loadu_ps(&segments.ey[k]);
+
+            const auto denom = _mm_sub_ps(
+                    _mm_mul_ps(ey, bdx), _mm_mul_ps(ex, bdy));
+
+            const auto y13 = _mm_sub_ps(y1, y3);
+            const auto x13 = _mm_sub_ps(x1, x3);
+
+            const auto ua = _mm_div_ps(_mm_sub_ps(
+                        _mm_mul_ps(ex, y13), _mm_mul_ps(ey, x13)), denom);
+            const auto ub = _mm_div_ps(_mm_sub_ps(
+                        _mm_mul_ps(bdx, y13), _mm_mul_ps(bdy, x13)), denom);
+
+            auto hit = _mm_cmpneq_ps(denom, zero);
+            hit = _mm_and_ps(hit, _mm_cmpge_ps(ua, zero));
+            hit = _mm_and_ps(hit, _mm_cmple_ps(ua, one));
+            hit = _mm_and_ps(hit, _mm_cmpge_ps(ub, zero));
+            hit = _mm_and_ps(hit, _mm_cmple_ps(ub, one));
+
+            const auto px = _mm_add_ps(x1, _mm_mul_ps(ua, bdx));
+            const auto py = _mm_add_ps(y1, _mm_mul_ps(ua, bdy));
+            const auto dx = _mm_sub_ps(x1, px);
+            const auto dy = _mm_sub_ps(y1, py);
+            const auto xy2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            const auto dz = _mm_mul_ps(neg_tan, _mm_sqrt_ps(xy2));
+            const auto xyzdist = _mm_sub_ps(
+                    _mm_sqrt_ps(_mm_add_ps(xy2, _mm_mul_ps(dz, dz))),
+                    _mm_loadu_ps(&segments.half_thickness[k]));
+            const auto pz = _mm_add_ps(bz, dz);
+
+            hit = _mm_and_ps(hit, _mm_cmplt_ps(pz,
+                        _mm_loadu_ps(&segments.height[k])));
+
+            const auto d = _mm_or_ps(_mm_and_ps(hit, xyzdist),
+                    _mm_andnot_ps(hit, inf));
+            const auto closer = _mm_cmplt_ps(d, best);
+            const auto closer_int = _mm_castps_si128(closer);
+
+            best = _mm_or_ps(_mm_and_ps(closer, d),
+                    _mm_andnot_ps(closer, best));
+            best_index = _mm_or_si128(_mm_and_si128(closer_int, lane_index),
+                    _mm_andnot_si128(closer_int, best_index));
+            lane_index = _mm_add_epi32(lane_index, four);
+        }
+
+        float lane_best[4] = {};
+        uint32_t lane_best_index[4] = {};
+        _mm_storeu_ps(lane_best, best);
+        _mm_storeu_si128((__m128i *)lane_best_index, best_index);
+
+        for (int j=0; j<4; ++j) {
+            reduce_nearest(lane_best[j], (size_t)lane_best_index[j],
+                    dist, index);
+        }
+
+#endif
+
+        for (; k<segments.count; ++k) {
+            reduce_nearest(intersect_with_segment(beam, segments, k), k,
+                    dist, index);
+        }
+
+        return dist;
+    }
+}
@@ -0,0 +1,291 @@
+/*
+   Work-stealing thread pool for splitting sensor reads across cores
+
+   Copyright (C) 2026 Simon D. Levy
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, in version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program. If not, see <http:--www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace simsens {
+
+    class ThreadPool {
+
+        public:
+
+            // Loops whose estimated work (items times cost per item) falls
+            // below this run inline on the calling thread
+            size_t min_parallel_work;
+
+            // Zero threads means one per hardware thread; the calling thread
+            // always takes part, so a pool of one runs everything inline
+            ThreadPool(const size_t nthreads=0)
+            {
+                min_parallel_work = 1 << 16;
+
+                participants = nthreads > 0 ? nthreads :
+                    max(1u, thread::hardware_concurrency());
+
+                slots.reset(new slot_t[participants]);
+
+                generation = 0;
+                active = 0;
+                remaining = 0;
+                stopping = false;
+
+                for (size_t k=1; k<participants; ++k) {
+                    workers.push_back(thread(&ThreadPool::worker_loop, this, k));
+                }
+            }
+
+            ~ThreadPool()
+            {
+                {
+                    lock_guard<mutex> lock(state_mutex);
+                    stopping = true;
+                }
+
+                wake.notify_all();
+
+                for (auto & worker : workers) {
+                    worker.join();
+                }
+            }
+
+            // Shared pool used by sensors that haven't been given their own
+            static ThreadPool & shared()
+            {
+                static ThreadPool pool;
+                return pool;
+            }
+
+            size_t size() const
+            {
+                return participants;
+            }
+
+            // Calls body(begin, end) over [0,count) in chunks of chunk_size
+            // items.  Each participant starts with an equal share of chunks
+            // and steals half of another's remaining chunks when it runs
+            // out.  Which thread runs a chunk varies, but the chunks
+            // themselves do not, so results are the same for any pool size.
+            template <typename F>
+            void parallel_for(const size_t count, const size_t chunk_size,
+                    const size_t cost_per_item, F body)
+            {
+                const auto chunk = max(chunk_size, (size_t)1);
+                const auto nchunks = (count + chunk - 1) / chunk;
+
+                if (participants == 1 || nchunks <= 1 || in_pool() ||
+                        count * cost_per_item < min_parallel_work) {
+                    body(0, count);
+                    return;
+                }
+
+                lock_guard<mutex> job_lock(job_mutex);
+
+                {
+                    lock_guard<mutex> lock(state_mutex);
+
+                    job_context = &body;
+                    job_invoke = [](void * context,
+                            const size_t begin, const size_t end) {
+                        (*(F *)context)(begin, end);
+                    };
+                    job_count = count;
+                    job_chunk = chunk;
+
+                    remaining = nchunks;
+
+                    for (size_t p=0; p<participants; ++p) {
+                        slots[p].range.store(pack(
+                                    nchunks * p / participants,
+                                    nchunks * (p + 1) / participants));
+                    }
+
+                    generation++;
+                    active++;
+                }
+
+                wake.notify_all();
+
+                in_pool() = true;
+                work(0);
+                in_pool() = false;
+
+                unique_lock<mutex> lock(state_mutex);
+                active--;
+                done.wait(lock, [this] {
+                        return remaining.load() == 0 && active == 0;
+                        });
+            }
+
+        private:
+
+            // Keep each participant's range on its own cache line
+            struct alignas(64) slot_t {
+                atomic<uint64_t> range;
+            };
+
+            size_t participants;
+            unique_ptr<slot_t[]> slots;
+            vector<thread> workers;
+
+            mutex job_mutex;
+            mutex state_mutex;
+            condition_variable wake;
+            condition_variable done;
+
+            uint64_t generation;
+            size_t active;
+            bool stopping;
+            atomic<size_t> remaining;
+
+            void * job_context;
+            void (*job_invoke)(void *, size_t, size_t);
+            size_t job_count;
+            size_t job_chunk;
+
+            static bool & in_pool()
+            {
+                thread_local bool flag = false;
+                return flag;
+            }
+
+            static uint64_t pack(const uint64_t begin, const uint64_t end)
+            {
+                return begin | (end << 32);
+            }
+
+            static uint64_t range_begin(const uint64_t range)
+            {
+                return range & 0xffffffff;
+            }
+
+            static uint64_t range_end(const uint64_t range)
+            {
+                return range >> 32;
+            }
+
+            void worker_loop(const size_t id)
+            {
+                in_pool() = true;
+
+                uint64_t seen = 0;
+
+                while (true) {
+
+                    {
+                        unique_lock<mutex> lock(state_mutex);
+                        wake.wait(lock, [this, seen] {
+                                return stopping || generation != seen;
+                                });
+                        if (stopping) {
+                            return;
+                        }
+                        seen = generation;
+                        active++;
+                    }
+
+                    work(id);
+
+                    {
+                        lock_guard<mutex> lock(state_mutex);
+                        active--;
+                    }
+
+                    done.notify_all();
+                }
+            }
+
+            void work(const size_t id)
+            {
+                while (true) {
+
+                    size_t chunk = 0;
+
+                    if (!take_own(id, chunk) && !steal(id, chunk)) {
+                        return;
+                    }
+
+                    const auto begin = chunk * job_chunk;
+                    job_invoke(job_context, begin,
+                            min(begin + job_chunk, job_count));
+
+                    if (remaining.fetch_sub(1) == 1) {
+                        lock_guard<mutex> lock(state_mutex);
+                        done.notify_all();
+                    }
+                }
+            }
+
+            // Takes the next chunk from the front of our own range
+            bool take_own(const size_t id, size_t & chunk)
+            {
+                auto & range = slots[id].range;
+                auto current = range.load();
+
+                while (range_begin(current) < range_end(current)) {
+                    if (range.compare_exchange_weak(current,
+                                pack(range_begin(current) + 1,
+                                    range_end(current)))) {
+                        chunk = range_begin(current);
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            // Takes the back half of another participant's range, keeps
+            // its first chunk and leaves the rest stealable in our slot
+            bool steal(const size_t id, size_t & chunk)
+            {
+                for (size_t k=1; k<participants; ++k) {
+
+                    auto & range = slots[(id + k) % participants].range;
+                    auto current = range.load();
+
+                    while (range_begin(current) < range_end(current)) {
+
+                        const auto begin = range_begin(current);
+                        const auto end = range_end(current);
+                        const auto half = (end - begin + 1) / 2;
+
+                        if (range.compare_exchange_weak(current,
+                                    pack(begin, end - half))) {
+                            chunk = end - half;
+                            slots[id].range.store(pack(chunk + 1, end));
+                            return true;
+                        }
+                    }
+                }
+
+                return false;
+            }
+    };
+
+}
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 namespace simsens {
 
     typedef struct {
@@ -48,4 +50,32 @@ namespace simsens {
         double alpha;
     } rotation_t;
 
+    // Distance from a query to the nearest obstacle's surface (negative
+    // inside it), and that obstacle's id, as in a rangefinder's wall ids,
+    // or -1 if there are none
+    typedef struct {
+        double clearance_m;
+        int wall_index;
+    } collision_t;
+
+    typedef enum {
+        ACCELERATOR_NONE,
+        ACCELERATOR_GRID,
+        ACCELERATOR_BVH,
+        ACCELERATOR_DISTANCE_FIELD
+    } accelerator_t;
+
+    typedef enum {
+        OBSTACLE_WALL,
+        OBSTACLE_BOX,
+        OBSTACLE_CYLINDER
+    } obstacle_type_t;
+
+    // A wall, box, or cylinder by its index among those of its type, which
+    // stays the same until it is removed
+    typedef struct {
+        obstacle_type_t type;
+        uint32_t index;
+    } obstacle_t;
+
 };
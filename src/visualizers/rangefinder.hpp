@@ -1,4 +1,4 @@
-/* 
+/*
    Rangefinder simulation visualizer using OpenCV
 
    Copyright (C) 2025 Simon D. Levy
@@ -18,16 +18,195 @@
 
 #pragma once
 
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
 #include <opencv2/opencv.hpp>
 
+#include <simsensors/src/profiler.hpp>
 #include <simsensors/src/sensors/rangefinder.hpp>
 
 namespace simsens {
 
+    // Turns depth images into grayscale pictures, near walls dark and no
+    // return white.  A visualizer can show them in a window, or, on a
+    // machine with no display, hand them to a background thread that
+    // writes them as a PNG sequence or a video, so that the simulation
+    // never waits on encoding.
     class RangefinderVisualizer {
 
         public:
 
+            RangefinderVisualizer(
+                    const double min_distance_m,
+                    const double max_distance_m,
+                    const int width,
+                    const int height,
+                    const int scaleup)
+            {
+                init(min_distance_m, max_distance_m, width, height, scaleup);
+            }
+
+            RangefinderVisualizer(const Rangefinder & rangefinder,
+                    const int scaleup)
+            {
+                init(rangefinder.min_distance_m, rangefinder.max_distance_m,
+                        rangefinder.width, rangefinder.height, scaleup);
+            }
+
+            ~RangefinderVisualizer()
+            {
+                stop();
+            }
+
+            // The picture of a width x height image of distances, scaled
+            // up; valid until the next call
+            const cv::Mat & render(const int * distances_mm)
+            {
+                SIMSENS_SCOPE(SCOPE_VISUALIZE);
+
+                to_gray(distances_mm, image);
+
+                cv::resize(image, scaled, scaled.size(), 0, 0,
+                        cv::INTER_NEAREST);
+
+                return scaled;
+            }
+
+            // Shows the picture in a window; needs a display
+            void show(const int * distances_mm, const char * window="lidar")
+            {
+                cv::imshow(window, render(distances_mm));
+
+                cv::waitKey(1);
+            }
+
+            // Starts writing frames passed to record() in the background.  A
+            // path with one printf-style integer field, like
+            // "frames/%05d.png", gets one image per frame, with any other
+            // percent sign written as %%; a path with none gets a video.
+            // Returns false if the path has any other conversion, or the
+            // video can't be opened.
+            bool start(const string & path,
+                    const double frames_per_second=30,
+                    const size_t max_queued_frames=8)
+            {
+                stop();
+
+                const auto fields = integer_fields(path);
+
+                if (fields < 0 || fields > 1) {
+                    fprintf(stderr, "Output file pattern %s needs exactly one "
+                            "%%d field\n", path.c_str());
+                    return false;
+                }
+
+                this->path = path;
+                this->max_queued_frames = max(max_queued_frames, (size_t)1);
+                frame_count = 0;
+                dropped_count = 0;
+                stopping = false;
+
+                if (fields == 0) {
+
+                    const auto avi = path.size() >= 4 &&
+                        path.compare(path.size() - 4, 4, ".avi") == 0;
+
+                    video.open(path,
+                            avi ? cv::VideoWriter::fourcc('M','J','P','G') :
+                            cv::VideoWriter::fourcc('m','p','4','v'),
+                            frames_per_second, scaled.size(), false);
+
+                    if (!video.isOpened()) {
+                        fprintf(stderr, "Unable to open file %s for output\n",
+                                path.c_str());
+                        return false;
+                    }
+                }
+
+                writer = thread(&RangefinderVisualizer::write_loop, this);
+
+                return true;
+            }
+
+            // Queues a frame for writing without waiting for the encoder.
+            // Only the small image is converted here; scaling happens on
+            // the writer thread.  If the queue is full the frame is dropped
+            // and false is returned.
+            bool record(const int * distances_mm)
+            {
+                SIMSENS_SCOPE(SCOPE_VISUALIZE);
+
+                if (!writer.joinable()) {
+                    return false;
+                }
+
+                cv::Mat frame;
+
+                {
+                    lock_guard<mutex> lock(queue_mutex);
+
+                    if (queue.size() >= max_queued_frames) {
+                        dropped_count++;
+                        return false;
+                    }
+
+                    // Reuse a buffer the writer has finished with
+                    if (!spare.empty()) {
+                        frame = spare.back();
+                        spare.pop_back();
+                    }
+                }
+
+                to_gray(distances_mm, frame);
+
+                {
+                    lock_guard<mutex> lock(queue_mutex);
+                    queue.push_back(frame);
+                }
+
+                queue_ready.notify_one();
+
+                return true;
+            }
+
+            // Writes whatever is queued, then closes the output
+            void stop()
+            {
+                if (!writer.joinable()) {
+                    return;
+                }
+
+                {
+                    lock_guard<mutex> lock(queue_mutex);
+                    stopping = true;
+                }
+
+                queue_ready.notify_one();
+
+                writer.join();
+
+                video.release();
+            }
+
+            // Frames record() dropped because the writer fell behind
+            size_t dropped()
+            {
+                lock_guard<mutex> lock(queue_mutex);
+                return dropped_count;
+            }
+
+            // Shows one image without keeping a visualizer around
             static void show(
                     const int * distances_mm,
                     const double min_distance_m,
@@ -36,31 +215,170 @@ namespace simsens {
                     const int height,
                     const int scaleup)
             {
-                const int new_width = width * scaleup;
-                const int new_height = height * scaleup;
+                RangefinderVisualizer(min_distance_m, max_distance_m,
+                        width, height, scaleup).show(distances_mm);
+            }
+
+        private:
+
+            int width;
+            int height;
+            int scaleup;
+
+            // Gray level for each distance in millimeters up to the
+            // maximum range, then one for no return
+            vector<uint8_t> lut;
+
+            cv::Mat image;
+            cv::Mat scaled;
+
+            string path;
+            cv::VideoWriter video;
+            thread writer;
+
+            mutex queue_mutex;
+            condition_variable queue_ready;
+            deque<cv::Mat> queue;
+            vector<cv::Mat> spare;
+            size_t max_queued_frames;
+            size_t frame_count;
+            size_t dropped_count;
+            bool stopping;
+
+            void init(
+                    const double min_distance_m,
+                    const double max_distance_m,
+                    const int width,
+                    const int height,
+                    const int scaleup)
+            {
+                this->width = width;
+                this->height = height;
+                this->scaleup = scaleup;
+
+                const auto max_mm = (int)(max_distance_m * 1000);
 
-                cv::Mat img = cv::Mat::zeros(new_height, new_width, CV_8UC1);
+                lut.resize(max(max_mm, 0) + 2);
 
-                for (uint8_t x=0; x<width; ++x) {
+                for (int d_mm=0; d_mm<=max_mm; ++d_mm) {
+                    const auto gray = (d_mm/1000. - min_distance_m) /
+                        (max_distance_m - min_distance_m) * 255;
+                    lut[d_mm] = gray <= 0 ? 0 : gray >= 255 ? 255 :
+                        (uint8_t)gray;
+                }
+
+                lut.back() = 255;
+
+                image.create(height, width, CV_8UC1);
+                scaled.create(height * scaleup, width * scaleup, CV_8UC1);
+
+                max_queued_frames = 1;
+                frame_count = 0;
+                dropped_count = 0;
+                stopping = false;
+            }
+
+            // One pass over the image, row by row; distances past the
+            // maximum range (as noise can give) get its gray level
+            void to_gray(const int * distances_mm, cv::Mat & gray) const
+            {
+                gray.create(height, width, CV_8UC1);
 
-                    for (uint8_t y=0; y<height; ++y) {
+                const auto no_return = lut.size() - 1;
+                const auto farthest = (int)lut.size() - 2;
 
-                        const int d_mm = distances_mm[y * width + x];
+                for (int y=0; y<height; ++y) {
 
-                        const uint8_t gray = d_mm == -1 ? 255 : 
-                            (uint8_t)((d_mm/1000. - min_distance_m) /
-                                    (max_distance_m - min_distance_m) * 255);
+                    const auto row = distances_mm + y * width;
+                    auto out = gray.ptr<uint8_t>(y);
 
-                        cv::rectangle(img,
-                                cv::Point(x*scaleup, y*scaleup),
-                                cv::Point((x+1)*scaleup, (y+1)*scaleup),
-                                gray, -1);
+                    for (int x=0; x<width; ++x) {
+                        const auto d_mm = row[x];
+                        out[x] = lut[d_mm == -1 ? no_return :
+                            min(max(d_mm, 0), farthest)];
                     }
                 }
+            }
 
-                cv::imshow("lidar", img);
+            // How many %d fields, each with an optional width, a path has
+            // besides escaped %% signs, or -1 if it has any other
+            // conversion, which would misread the frame number
+            static int integer_fields(const string & path)
+            {
+                int fields = 0;
 
-                cv::waitKey(1);
+                for (size_t k=0; k<path.size(); ++k) {
+
+                    if (path[k] != '%') {
+                        continue;
+                    }
+
+                    if (k + 1 < path.size() && path[k+1] == '%') {
+                        k++;
+                        continue;
+                    }
+
+                    while (k + 1 < path.size() && isdigit(path[k+1])) {
+                        k++;
+                    }
+
+                    if (k + 1 >= path.size() || path[k+1] != 'd') {
+                        return -1;
+                    }
+
+                    k++;
+                    fields++;
+                }
+
+                return fields;
+            }
+
+            void write_loop()
+            {
+                cv::Mat big;
+
+                while (true) {
+
+                    cv::Mat frame;
+
+                    {
+                        unique_lock<mutex> lock(queue_mutex);
+
+                        queue_ready.wait(lock, [this] {
+                                return stopping || !queue.empty();
+                                });
+
+                        if (queue.empty()) {
+                            return;
+                        }
+
+                        frame = queue.front();
+                        queue.pop_front();
+                    }
+
+                    cv::resize(frame, big, cv::Size(), scaleup, scaleup,
+                            cv::INTER_NEAREST);
+
+                    if (video.isOpened()) {
+                        video.write(big);
+                    }
+
+                    else {
+                        char file_name[1000] = {};
+                        snprintf(file_name, sizeof(file_name), path.c_str(),
+                                (int)frame_count);
+                        if (!cv::imwrite(file_name, big)) {
+                            fprintf(stderr,
+                                    "Unable to open file %s for output\n",
+                                    file_name);
+                        }
+                    }
+
+                    frame_count++;
+
+                    lock_guard<mutex> lock(queue_mutex);
+                    spare.push_back(frame);
+                }
             }
     };
 
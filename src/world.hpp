@@ -18,23 +18,65 @@
 
 #pragma once
 
+#include <string.h>
+
+#include <type_traits>
+
+#include <simsensors/src/math.hpp>
+#include <simsensors/src/profiler.hpp>
+#include <simsensors/src/simd.hpp>
+#include <simsensors/src/accelerators/bvh.hpp>
+#include <simsensors/src/accelerators/field.hpp>
+#include <simsensors/src/accelerators/grid.hpp>
+#include <simsensors/src/collision.hpp>
+#include <simsensors/src/obstacles/box.hpp>
+#include <simsensors/src/obstacles/cylinder.hpp>
+#include <simsensors/src/obstacles/names.hpp>
+#include <simsensors/src/obstacles/plane.hpp>
 #include <simsensors/src/obstacles/wall.hpp>
+#include <simsensors/src/obstacles/segments.hpp>
 
 namespace simsens {
 
     class World {
 
         friend class WorldParser;
+        friend class WorldCache;
         friend class Rangefinder;
         friend class CollisionDetector;
+        friend class Robot;
 
         private:
 
-            vector<Wall *> walls;
+            // Wall geometry, by value in wall-file order
+            vector<Wall> walls;
+
+            // Each wall's name, by its index in walls
+            NameTable names;
+            vector<uint32_t> wall_names;
+
+            WallSegments segments;
+
+            // Other obstacles, one array per type
+            Boxes boxes;
+            Cylinders cylinders;
+            Planes planes;
+            vector<uint32_t> box_names;
+            vector<uint32_t> cylinder_names;
+            vector<uint32_t> plane_names;
+
+            // The same walls rounded to single precision, for float reads
+            BasicWallSegments<float> float_segments;
 
-            pose_t robotPose;
+            accelerator_t accelerator = ACCELERATOR_NONE;
+            double grid_cell_size_m = 0;
+            UniformGrid grid;
+            Bvh bvh;
+            DistanceField field;
 
-            bool y_inverted;
+            pose_t robotPose = {};
+
+            bool y_inverted = false;
 
             vec3_t adjust_location(const vec3_t & loc)
             {
@@ -47,54 +89,957 @@ namespace simsens {
                         pose.phi, pose.theta, pose.psi};
             }
 
-            double yinvert(const double y)
+            double yinvert(const double y) const
             {
                 return y_inverted ? -y : y;
             }
 
+            // An obstacle's id, as reads and collisions report it, has its
+            // type in the top bits and its index among obstacles of that
+            // type below, so that adding one never renumbers the others.
+            // A wall's id is its index.
+            static constexpr int ID_TYPE_SHIFT = 28;
+            static constexpr size_t BOX_IDS = (size_t)1 << ID_TYPE_SHIFT;
+            static constexpr size_t CYLINDER_IDS = (size_t)2 << ID_TYPE_SHIFT;
+            static constexpr size_t PLANE_IDS = (size_t)3 << ID_TYPE_SHIFT;
+            static constexpr size_t ID_INDEX_MASK = BOX_IDS - 1;
+
             // Arbitrary limits
             static constexpr double COLLISION_TOLERANCE_M = 0.05;
+            static constexpr double DEFAULT_FIELD_CELL_SIZE_M = 0.1;
+            static constexpr double GRADIENT_STEP_M = 1e-3;
+
+            void add_wall(const Wall & wall, const string_view name)
+            {
+                walls.push_back(wall);
+                wall_names.push_back(names.intern(name));
+            }
+
+            void add_box(const vec3_t & translation,
+                    const rotation_t & rotation, const vec3_t & size,
+                    const string_view name)
+            {
+                boxes.add(translation, rotation, size);
+                box_names.push_back(names.intern(name));
+            }
+
+            void add_cylinder(const vec3_t & translation,
+                    const double radius, const double height,
+                    const string_view name)
+            {
+                cylinders.add(translation, radius, height);
+                cylinder_names.push_back(names.intern(name));
+            }
+
+            void add_plane(const double z, const string_view name)
+            {
+                planes.add(z);
+                plane_names.push_back(names.intern(name));
+            }
+
+            size_t obstacle_count() const
+            {
+                return segments.count + boxes.size() + cylinders.size() +
+                    planes.size();
+            }
+
+            void build_segment_cache()
+            {
+                segments.build(walls);
+                float_segments.assign(segments);
+
+                build_accelerator();
+            }
+
+            template <typename T>
+            const BasicWallSegments<T> & segments_for() const
+            {
+                if constexpr (is_same<T, float>::value) {
+                    return float_segments;
+                }
+                else {
+                    return segments;
+                }
+            }
+
+            void build_accelerator()
+            {
+                switch (accelerator) {
+                    case ACCELERATOR_GRID:
+                        grid.build(segments, grid_cell_size_m);
+                        break;
+                    case ACCELERATOR_BVH:
+                        bvh.build(segments);
+                        break;
+                    case ACCELERATOR_DISTANCE_FIELD:
+                        grid.build(segments);
+                        break;
+                    default:
+                        break;
+                }
+
+                build_distance_field();
+            }
+
+            // Samples every wall, box, and cylinder but the movers into the
+            // distance field, at the grid cell size given to
+            // use_accelerator(), or else at a quarter of the automatic cell
+            // size of the grid over the walls that refines its hits
+            void build_distance_field()
+            {
+                if (accelerator != ACCELERATOR_DISTANCE_FIELD) {
+                    field = DistanceField();
+                    return;
+                }
+
+                vector<size_t> moving;
+
+                for (const auto & mover : movers) {
+                    moving.push_back(obstacle_id(mover));
+                }
+
+                sort(moving.begin(), moving.end());
+
+                vector<DistanceField::footprint_t> footprints;
+
+                auto add = [&](const size_t id) {
+                    DistanceField::footprint_t f = {};
+                    if (!binary_search(moving.begin(), moving.end(), id) &&
+                            footprint(id, f)) {
+                        footprints.push_back(f);
+                    }
+                };
+
+                for (size_t k=0; k<segments.count; ++k) {
+                    add(k);
+                }
+
+                for (size_t k=0; k<boxes.size(); ++k) {
+                    add(BOX_IDS + k);
+                }
+
+                for (size_t k=0; k<cylinders.size(); ++k) {
+                    add(CYLINDER_IDS + k);
+                }
+
+                const auto cell_size_m = grid_cell_size_m > 0 ?
+                    grid_cell_size_m : grid.cell_size_m() / 4;
+
+                field.build(footprints,
+                        cell_size_m > 0 ? cell_size_m : DEFAULT_FIELD_CELL_SIZE_M,
+                        [this](const size_t k, const double x, const double y) {
+                        return footprint_distance(k, x, y);
+                        });
+            }
+
+            // Where the wall, box, or cylinder with the given id stands,
+            // for the distance field, or false if it has been removed
+            bool footprint(const size_t id,
+                    DistanceField::footprint_t & f) const
+            {
+                // Boxes and cylinders include their tops
+                auto above = [](const double z) {
+                    return nextafter(z, INFINITY);
+                };
+
+                const auto index = (uint32_t)id;
+                const auto k = id & ID_INDEX_MASK;
+
+                if (id < segments.count) {
+
+                    const auto ht = segments.half_thickness[k];
+
+                    f = DistanceField::footprint_t {index,
+                        min(segments.x3[k], segments.x3[k] + segments.ex[k]) - ht,
+                        min(segments.y3[k], segments.y3[k] + segments.ey[k]) - ht,
+                        max(segments.x3[k], segments.x3[k] + segments.ex[k]) + ht,
+                        max(segments.y3[k], segments.y3[k] + segments.ey[k]) + ht,
+                        -INFINITY, segments.height[k]};
+
+                    return segments.height[k] > -INFINITY;
+                }
+
+                if (id - k == BOX_IDS && k < boxes.size()) {
+
+                    const auto & b = boxes.items[k];
+
+                    const auto rx = fabs(b.xx) * b.hx + fabs(b.yx) * b.hy;
+                    const auto ry = fabs(b.xy) * b.hx + fabs(b.yy) * b.hy;
+
+                    f = DistanceField::footprint_t {index,
+                        b.cx - rx, b.cy - ry, b.cx + rx, b.cy + ry,
+                        b.cz - b.hz, above(b.cz + b.hz)};
+
+                    return !boxes.removed(k);
+                }
+
+                if (id - k == CYLINDER_IDS && k < cylinders.size()) {
+
+                    const auto & c = cylinders.items[k];
+
+                    f = DistanceField::footprint_t {index,
+                        c.cx - c.radius, c.cy - c.radius,
+                        c.cx + c.radius, c.cy + c.radius,
+                        c.zmin, above(c.zmax)};
+
+                    return !cylinders.removed(k);
+                }
+
+                return false;
+            }
+
+            // Signed XY distance from a point to the wall, box, or cylinder
+            // with the given id, at any height
+            double footprint_distance(const size_t id,
+                    const double x, const double y) const
+            {
+                const auto k = id & ID_INDEX_MASK;
+
+                return id < segments.count ?
+                    CollisionDetector::point_to_wall(segments, id, x, y) :
+                    id - k == BOX_IDS ? boxes.footprint_distance(k, x, y) :
+                    cylinders.footprint_distance(k, x, y);
+            }
 
-            static bool intersect_with_wall_at_azimuth(
-                    const vec3_t & robot_location,
-                    const Wall & wall,
-                    const double azimuth)
+            // Same, but INFINITY for an obstacle above or below the point
+            double obstacle_clearance(const size_t id, const vec3_t & loc) const
             {
-                return intersect_with_wall(
-                        robot_location,
-                        azimuth,
-                        0, // elevation
-                        wall)
+                const auto k = id & ID_INDEX_MASK;
 
-                    < COLLISION_TOLERANCE_M;
+                if (id < segments.count) {
+                    return loc.z < segments.height[id] ?
+                        CollisionDetector::point_to_wall(
+                                segments, id, loc.x, loc.y) : INFINITY;
+                }
+
+                return id - k == BOX_IDS ?
+                    boxes.clearance(k, loc.x, loc.y, loc.z) :
+                    cylinders.clearance(k, loc.x, loc.y, loc.z);
+            }
+
+            // Clearance in constant time from the distance field, or false
+            // if a disc of the given radius at the location is too near an
+            // obstacle for the field to tell whether it has collided, or
+            // too far from all of them for the field to bound it closely.
+            // The obstacles nearest the samples around the location, and
+            // the movers, measured exactly, bound the clearance from above;
+            // the field bounds it from below.  Where the two meet, the
+            // clearance is exact; elsewhere it is the lower bound, within a
+            // cell's diagonal of the truth.
+            bool field_clearance(const vec3_t & loc, const double radius_m,
+                    collision_t & collision) const
+            {
+                double dist = INFINITY;
+                size_t index = NO_OBSTACLE;
+
+                double lower = INFINITY;
+
+                const auto layer = field.layer_at(loc.z);
+
+                if (layer) {
+
+                    lower = field.lower_bound(*layer, loc.x, loc.y);
+
+                    uint32_t candidates[16] = {};
+                    field.candidates(*layer, loc.x, loc.y, candidates);
+
+                    auto previous = DistanceField::NONE;
+
+                    for (const auto k : candidates) {
+                        if (k != DistanceField::NONE && k != previous) {
+                            reduce_nearest(obstacle_clearance(k, loc),
+                                    (size_t)k, dist, index);
+                        }
+                        previous = k;
+                    }
+                }
+
+                for (const auto & mover : movers) {
+                    const auto id = obstacle_id(mover);
+                    reduce_nearest(obstacle_clearance(id, loc), id, dist, index);
+                }
+
+                if (dist > lower &&
+                        (lower - radius_m < COLLISION_TOLERANCE_M ||
+                         dist - lower > field.cell_diagonal())) {
+                    return false;
+                }
+
+                collision = collision_t {min(dist, lower),
+                    index != NO_OBSTACLE ? (int)index : -1};
+
+                return true;
+            }
+
+            // Clearance by searching the spatial index
+            collision_t exact_clearance(const vec3_t & loc) const
+            {
+                auto collision = nearest_to_box(loc.x, loc.y, loc.x, loc.y,
+                        [this, &loc](const size_t k) {
+                        return loc.z < segments.height[k] ?
+                        CollisionDetector::point_to_wall(
+                                segments, k, loc.x, loc.y) : INFINITY;
+                        });
+
+                nearest_primitive_to(collision,
+                        [&loc](const Boxes & shapes, const size_t k) {
+                        return shapes.clearance(k, loc.x, loc.y, loc.z);
+                        },
+                        [&loc](const Cylinders & shapes, const size_t k) {
+                        return shapes.clearance(k, loc.x, loc.y, loc.z);
+                        });
+
+                return collision;
+            }
+
+            // Distance to the nearest obstacle along the beam, or INFINITY,
+            // with its id, or NO_OBSTACLE for none.  A finite bound
+            // seeds the search with a known hit on the obstacle passed in
+            // index.  A float beam is tested against the float walls; the
+            // spatial indexes, built from the double walls, serve both.
+            template <typename T>
+            T nearest_wall(const basic_beam_t<T> & beam, size_t & index,
+                    const T bound=INFINITY) const
+            {
+                const auto & segments = segments_for<T>();
+
+                T dist = INFINITY;
+
+                switch (accelerator) {
+                    case ACCELERATOR_GRID:
+                        dist = grid.nearest(beam, segments, index, bound);
+                        break;
+                    case ACCELERATOR_BVH:
+                        dist = bvh.nearest(beam, segments, index, bound);
+                        break;
+                    case ACCELERATOR_DISTANCE_FIELD: {
+                        double t = 0;
+                        if (field.march(beam, t)) {
+                            dist = grid.nearest(beam, segments, index, bound, t);
+                        }
+                        else {
+                            dist = bound;
+                            index = bound < INFINITY ? index : segments.count;
+                        }
+                        nearest_moving_wall(beam, dist, index);
+                        break;
+                    }
+                    default:
+                        const auto seed_index = index;
+                        dist = nearest_segment_on_beam(beam, segments, index);
+                        reduce_nearest(bound, seed_index, dist, index);
+                }
+
+                nearest_primitive(beam, dist, index);
+
+                return dist;
+            }
+
+            // Reduces the nearest of the walls left out of the distance
+            // field, which its march can pass through, into dist and index
+            template <typename T>
+            void nearest_moving_wall(const basic_beam_t<T> & beam,
+                    T & dist, size_t & index) const
+            {
+                for (const auto & mover : movers) {
+                    if (mover.type == OBSTACLE_WALL) {
+                        reduce_nearest(intersect_with_segment(beam,
+                                    segments_for<T>(), mover.index),
+                                (size_t)mover.index, dist, index);
+                    }
+                }
             }
 
-         public:
+            // Reduces the nearest box, cylinder, or plane on the beam into
+            // dist and index.  The few of these a world has are tested
+            // type by type, outside the spatial indexes.
+            template <typename T>
+            void nearest_primitive(const basic_beam_t<T> & beam,
+                    T & dist, size_t & index) const
+            {
+                ray_t ray = {};
+
+                if (obstacle_count() > segments.count && make_ray(beam, ray)) {
+                    nearest_of(boxes, ray, BOX_IDS, dist, index);
+                    nearest_of(cylinders, ray, CYLINDER_IDS, dist, index);
+                    nearest_of(planes, ray, PLANE_IDS, dist, index);
+                }
+
+                if (!(dist < INFINITY)) {
+                    index = NO_OBSTACLE;
+                }
+            }
+
+            // Distance along the beam to the given obstacle, or INFINITY,
+            // and where the beam meets it if asked
+            template <typename T>
+            double obstacle_distance(const basic_beam_t<T> & beam,
+                    const size_t id, vec3_t * point=nullptr) const
+            {
+                if (id < segments.count) {
+                    return intersect_with_segment(beam, segments_for<T>(),
+                            id, point);
+                }
+
+                ray_t ray = {};
+
+                if (!make_ray(beam, ray)) {
+                    return INFINITY;
+                }
+
+                const auto k = id & ID_INDEX_MASK;
+
+                double s = INFINITY;
+
+                if (id - k == BOX_IDS && k < boxes.size()) {
+                    s = boxes.intersect(ray, k);
+                }
+                else if (id - k == CYLINDER_IDS && k < cylinders.size()) {
+                    s = cylinders.intersect(ray, k);
+                }
+                else if (id - k == PLANE_IDS && k < planes.size()) {
+                    s = planes.intersect(ray, k);
+                }
+
+                if (point && s < INFINITY) {
+                    *point = ray_point(ray, s);
+                }
+
+                return s * ray.scale;
+            }
+
+            // Reduces the nearest box or cylinder by distance(shapes, k)
+            // into the collision
+            template <typename B, typename C>
+            void nearest_primitive_to(collision_t & collision,
+                    B box_distance, C cylinder_distance) const
+            {
+                size_t index = collision.wall_index < 0 ?
+                    NO_OBSTACLE : collision.wall_index;
+
+                for (size_t k=0; k<boxes.size(); ++k) {
+                    reduce_nearest(box_distance(boxes, k),
+                            BOX_IDS + k, collision.clearance_m, index);
+                }
+
+                for (size_t k=0; k<cylinders.size(); ++k) {
+                    reduce_nearest(cylinder_distance(cylinders, k),
+                            CYLINDER_IDS + k, collision.clearance_m, index);
+                }
+
+                collision.wall_index = index != NO_OBSTACLE ? (int)index : -1;
+            }
+
+            // Nearest wall by distance(k) to the query box, using the
+            // spatial index when there is one
+            template <typename F>
+            collision_t nearest_to_box(
+                    const double xmin, const double ymin,
+                    const double xmax, const double ymax,
+                    F distance) const
+            {
+                size_t index = segments.count;
+                double dist = INFINITY;
+
+                switch (accelerator) {
+                    case ACCELERATOR_GRID:
+                    case ACCELERATOR_DISTANCE_FIELD:
+                        dist = grid.nearest_to_box(xmin, ymin, xmax, ymax,
+                                segments, distance, index);
+                        break;
+                    case ACCELERATOR_BVH:
+                        dist = bvh.nearest_to_box(xmin, ymin, xmax, ymax,
+                                segments, distance, index);
+                        break;
+                    default:
+                        for (size_t k=0; k<segments.count; ++k) {
+                            reduce_nearest(distance(k), k, dist, index);
+                        }
+                }
+
+                return collision_t {dist,
+                    index < segments.count ? (int)index : -1};
+            }
+
+            rotation_t adjust_rotation(const rotation_t & rotation) const
+            {
+                return {rotation.x, rotation.y, rotation.z,
+                        y_inverted ? -rotation.alpha : rotation.alpha};
+            }
+
+            bool exists(const obstacle_t & obstacle) const
+            {
+                const auto k = obstacle.index;
+
+                switch (obstacle.type) {
+                    case OBSTACLE_WALL:
+                        return k < walls.size() && walls[k].size.z > -INFINITY;
+                    case OBSTACLE_BOX:
+                        return k < boxes.size() && !boxes.removed(k);
+                    case OBSTACLE_CYLINDER:
+                        return k < cylinders.size() && !cylinders.removed(k);
+                }
+
+                return false;
+            }
+
+            // Brings the segment caches and spatial index up to date with
+            // walls[k], which has moved, been removed, or been added after
+            // the others, rebuilding only if the wall has left the grid
+            void update_wall(const size_t k)
+            {
+                const auto added = k == segments.count;
+
+                if (added) {
+                    segments.add(walls[k]);
+                }
+                else {
+                    if (accelerator == ACCELERATOR_GRID ||
+                            accelerator == ACCELERATOR_DISTANCE_FIELD) {
+                        grid.remove(segments, k);
+                    }
+                    segments.set(k, walls[k]);
+                }
+
+                float_segments.assign(k, segments);
+
+                const auto has = walls[k].size.z > -INFINITY;
+
+                switch (accelerator) {
+                    case ACCELERATOR_GRID:
+                    case ACCELERATOR_DISTANCE_FIELD:
+                        if (has && !grid.insert(segments, k)) {
+                            build_accelerator();
+                            return;
+                        }
+                        break;
+                    case ACCELERATOR_BVH:
+                        if (added) {
+                            bvh.insert(segments, k);
+                        }
+                        else {
+                            bvh.refit(segments, k);
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            static size_t obstacle_id(const obstacle_t & obstacle)
+            {
+                return obstacle.index + (obstacle.type == OBSTACLE_WALL ? 0 :
+                        obstacle.type == OBSTACLE_BOX ? BOX_IDS : CYLINDER_IDS);
+            }
+
+            bool is_mover(const obstacle_t & obstacle) const
+            {
+                for (const auto & mover : movers) {
+                    if (mover.type == obstacle.type &&
+                            mover.index == obstacle.index) {
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            // Starts testing an obstacle one by one, as it is about to move
+            // from where it stood
+            void add_mover(const obstacle_t & obstacle)
+            {
+                if (!is_mover(obstacle)) {
+
+                    DistanceField::footprint_t before = {};
+                    footprint(obstacle_id(obstacle), before);
+
+                    movers.push_back(obstacle);
+
+                    if (accelerator == ACCELERATOR_DISTANCE_FIELD) {
+                        field.remove(before,
+                                [this](const size_t k, const double x,
+                                    const double y) {
+                                return footprint_distance(k, x, y);
+                                });
+                    }
+                }
+            }
+
+            // Slots of removed obstacles, for new ones to reuse
+            vector<uint32_t> free_walls;
+            vector<uint32_t> free_boxes;
+            vector<uint32_t> free_cylinders;
+
+            // Obstacles inserted or moved at run time.  The distance field
+            // leaves them out, even when rebuilt, so that they can move
+            // without redoing it; they are tested one by one instead.
+            vector<obstacle_t> movers;
+
+        public:
+
+            // The id reads and collisions give when there is no obstacle
+            static constexpr size_t NO_OBSTACLE = UINT32_MAX;
+
+            // Selects a spatial index over the walls, which pays off for
+            // worlds with many walls.  Can be called before or after parsing;
+            // a grid cell size of zero picks one automatically.  For a
+            // distance field, the cell size is the field's resolution.
+            void use_accelerator(
+                    const accelerator_t type, const double cell_size_m=0)
+            {
+                accelerator = type;
+                grid_cell_size_m = cell_size_m;
+
+                build_accelerator();
+            }
 
             bool collided(
                     const vec3_t & robot_location, const bool debug=false)
             {
-                const auto robloc = adjust_location(robot_location);
+                SIMSENS_SCOPE(SCOPE_COLLIDED);
+
+                const auto collision = clearance(robot_location);
+
+                if (collision.clearance_m < COLLISION_TOLERANCE_M) {
+                    if (debug) {
+                        printf("collided with wall: %s\n",
+                                wall_name(collision.wall_index));
+                    }
+                    return true;
+                }
+
+                return false;
+            }
+
+            // Distance from a disc of the given radius to the nearest wall
+            // lower than the disc's height, or box or cylinder spanning it.
+            // With a distance field, takes constant time inside the field
+            // away from obstacles, where it may understate the distance by
+            // up to a field cell's diagonal, but never overstates it.
+            collision_t clearance(
+                    const vec3_t & location, const double radius_m=0)
+            {
+                const auto loc = adjust_location(location);
+
+                collision_t collision = {};
+
+                if (!(accelerator == ACCELERATOR_DISTANCE_FIELD &&
+                            field.contains(loc.x, loc.y) &&
+                            field_clearance(loc, radius_m, collision))) {
+                    collision = exact_clearance(loc);
+                }
+
+                collision.clearance_m -= radius_m;
+
+                return collision;
+            }
+
+            // Closest a disc comes to any wall while moving in a straight
+            // line between two locations, so that a fast mover cannot
+            // tunnel through a thin wall between substeps
+            collision_t swept_clearance(
+                    const vec3_t & from,
+                    const vec3_t & to,
+                    const double radius_m=0)
+            {
+                const auto a = adjust_location(from);
+                const auto b = adjust_location(to);
+
+                // Walls rise from below the floor, so a segment meets
+                // one only where it passes under the wall's top
+                auto collision = nearest_to_box(
+                        min(a.x, b.x), min(a.y, b.y),
+                        max(a.x, b.x), max(a.y, b.y),
+                        [this, &a, &b](const size_t k) {
+                        vec3_t p = {}, q = {};
+                        return min(a.z, b.z) < segments.height[k] &&
+                        clip_segment_to_slab(a, b, -INFINITY,
+                                segments.height[k], p, q) ?
+                        CollisionDetector::segment_to_wall(
+                                segments, k, p.x, p.y, q.x, q.y) : INFINITY;
+                        });
+
+                nearest_primitive_to(collision,
+                        [&a, &b](const Boxes & shapes, const size_t k) {
+                        return shapes.swept_clearance(k, a, b);
+                        },
+                        [&a, &b](const Cylinders & shapes, const size_t k) {
+                        return shapes.swept_clearance(k, a, b);
+                        });
+
+                collision.clearance_m -= radius_m;
+
+                return collision;
+            }
+
+            // Clearance interpolated smoothly from the distance field, and
+            // its gradient if asked, for planners that descend it; where
+            // there is no field, the exact clearance and a zero gradient.
+            // In a world with more obstacle heights than the field has
+            // bands, it also counts obstacles at nearby heights.
+            double field_distance(const vec3_t & location,
+                    vec3_t * gradient=nullptr)
+            {
+                const auto loc = adjust_location(location);
+
+                const auto layer = accelerator == ACCELERATOR_DISTANCE_FIELD &&
+                    field.contains(loc.x, loc.y) ?
+                    field.layer_at(loc.z) : nullptr;
+
+                if (!layer) {
+                    if (gradient) {
+                        *gradient = {0, 0, 0};
+                    }
+                    return clearance(location).clearance_m;
+                }
+
+                double gx = 0, gy = 0;
+                auto dist = field.distance(*layer, loc.x, loc.y, &gx, &gy);
+
+                // Movers are measured exactly, with the gradient by central
+                // differences
+                for (const auto & mover : movers) {
+
+                    const auto k = obstacle_id(mover);
+                    const auto d = obstacle_clearance(k, loc);
+
+                    if (d < dist) {
+
+                        dist = d;
+
+                        const auto h = GRADIENT_STEP_M;
 
-                for (auto wall : walls) {
+                        gx = (footprint_distance(k, loc.x + h, loc.y) -
+                                footprint_distance(k, loc.x - h, loc.y)) / (2 * h);
 
-                    if (
-                            intersect_with_wall_at_azimuth(robloc, *wall, 0) 
-                            || intersect_with_wall_at_azimuth(robloc, *wall, M_PI/2)
-                            || intersect_with_wall_at_azimuth(robloc, *wall, M_PI) 
-                            || intersect_with_wall_at_azimuth(robloc, *wall, 3*M_PI/2)
-                       ) 
-                    {
-                        if (debug) {
-                            printf("collided with wall: %s\n", wall->name);
+                        gy = (footprint_distance(k, loc.x, loc.y + h) -
+                                footprint_distance(k, loc.x, loc.y - h)) / (2 * h);
+                    }
+                }
+
+                if (gradient) {
+                    *gradient = {gx, yinvert(gy), 0};
+                }
+
+                return dist;
+            }
+
+            bool collided(
+                    const vec3_t & from,
+                    const vec3_t & to,
+                    const bool debug=false)
+            {
+                SIMSENS_SCOPE(SCOPE_COLLIDED);
+
+                const auto collision = swept_clearance(from, to);
+
+                if (collision.clearance_m < COLLISION_TOLERANCE_M) {
+                    if (debug) {
+                        printf("collided with wall: %s\n",
+                                wall_name(collision.wall_index));
+                    }
+                    return true;
+                }
+
+                return false;
+            }
+
+            // Adds a wall between ticks, in the frame of robot poses, and
+            // returns its handle.  Removed walls' slots are reused.
+            obstacle_t insert_wall(const vec3_t & translation,
+                    const rotation_t & rotation, const vec3_t & size,
+                    const string_view name="")
+            {
+                Wall wall;
+                wall.translation = adjust_location(translation);
+                wall.rotation = adjust_rotation(rotation);
+                wall.size = size;
+
+                size_t k = walls.size();
+
+                if (free_walls.empty()) {
+                    add_wall(wall, name);
+                }
+                else {
+                    k = free_walls.back();
+                    free_walls.pop_back();
+                    walls[k] = wall;
+                    wall_names[k] = names.intern(name);
+                }
+
+                const obstacle_t obstacle = {OBSTACLE_WALL, (uint32_t)k};
+
+                movers.push_back(obstacle);
+
+                update_wall(k);
+
+                return obstacle;
+            }
+
+            // Same for a box
+            obstacle_t insert_box(const vec3_t & translation,
+                    const rotation_t & rotation, const vec3_t & size,
+                    const string_view name="")
+            {
+                const auto t = adjust_location(translation);
+                const auto r = adjust_rotation(rotation);
+
+                size_t k = boxes.size();
+
+                if (free_boxes.empty()) {
+                    add_box(t, r, size, name);
+                }
+                else {
+                    k = free_boxes.back();
+                    free_boxes.pop_back();
+                    boxes.set(k, t, r, size);
+                    box_names[k] = names.intern(name);
+                }
+
+                const obstacle_t obstacle = {OBSTACLE_BOX, (uint32_t)k};
+
+                movers.push_back(obstacle);
+
+                return obstacle;
+            }
+
+            // Same for a cylinder
+            obstacle_t insert_cylinder(const vec3_t & translation,
+                    const double radius, const double height,
+                    const string_view name="")
+            {
+                const auto t = adjust_location(translation);
+
+                size_t k = cylinders.size();
+
+                if (free_cylinders.empty()) {
+                    add_cylinder(t, radius, height, name);
+                }
+                else {
+                    k = free_cylinders.back();
+                    free_cylinders.pop_back();
+                    cylinders.set(k, t, radius, height);
+                    cylinder_names[k] = names.intern(name);
+                }
+
+                const obstacle_t obstacle = {OBSTACLE_CYLINDER, (uint32_t)k};
+
+                movers.push_back(obstacle);
+
+                return obstacle;
+            }
+
+            // Finds a wall, box, or cylinder by name, as from the world file
+            bool find_obstacle(const char * name, obstacle_t & obstacle) const
+            {
+                const vector<uint32_t> * ids[] = {
+                    &wall_names, &box_names, &cylinder_names};
+
+                const obstacle_type_t types[] = {
+                    OBSTACLE_WALL, OBSTACLE_BOX, OBSTACLE_CYLINDER};
+
+                for (size_t t=0; t<3; ++t) {
+                    for (uint32_t k=0; k<ids[t]->size(); ++k) {
+
+                        const obstacle_t found = {types[t], k};
+
+                        if (!strcmp(names.get((*ids[t])[k]), name) &&
+                                exists(found)) {
+                            obstacle = found;
+                            return true;
                         }
-                        return true;
                     }
                 }
 
                 return false;
             }
 
+            // Moves an obstacle between ticks, keeping its size, and
+            // updates the spatial index in place; a cylinder ignores the
+            // rotation.  The first move of an obstacle from the world file
+            // takes it out of the distance field, which costs up to a
+            // field rebuild; later ones cost microseconds.  Returns false
+            // if there is no such obstacle.
+            bool move_obstacle(const obstacle_t & obstacle,
+                    const vec3_t & translation, const rotation_t & rotation)
+            {
+                if (!exists(obstacle)) {
+                    return false;
+                }
+
+                add_mover(obstacle);
+
+                const auto t = adjust_location(translation);
+                const auto k = obstacle.index;
+
+                switch (obstacle.type) {
+                    case OBSTACLE_WALL:
+                        walls[k].translation = t;
+                        walls[k].rotation = adjust_rotation(rotation);
+                        update_wall(k);
+                        break;
+                    case OBSTACLE_BOX:
+                        boxes.move(k, t, adjust_rotation(rotation));
+                        break;
+                    case OBSTACLE_CYLINDER:
+                        cylinders.move(k, t);
+                        break;
+                }
+
+                return true;
+            }
+
+            // Removes an obstacle, leaving the others' handles and indices
+            // as they were.  Returns false if there is no such obstacle.
+            bool remove_obstacle(const obstacle_t & obstacle)
+            {
+                if (!exists(obstacle)) {
+                    return false;
+                }
+
+                add_mover(obstacle);
+
+                for (size_t m=0; m<movers.size(); ++m) {
+                    if (movers[m].type == obstacle.type &&
+                            movers[m].index == obstacle.index) {
+                        movers.erase(movers.begin() + m);
+                        break;
+                    }
+                }
+
+                const auto k = obstacle.index;
+
+                switch (obstacle.type) {
+                    case OBSTACLE_WALL:
+                        walls[k].size.z = -INFINITY;
+                        update_wall(k);
+                        free_walls.push_back(k);
+                        break;
+                    case OBSTACLE_BOX:
+                        boxes.remove(k);
+                        free_boxes.push_back(k);
+                        break;
+                    case OBSTACLE_CYLINDER:
+                        cylinders.remove(k);
+                        free_cylinders.push_back(k);
+                        break;
+                }
+
+                return true;
+            }
+
+            // Name of the obstacle with the given id
+            const char * wall_name(const size_t id) const
+            {
+                const auto k = id & ID_INDEX_MASK;
+
+                const auto ids = id - k == 0 ? &wall_names :
+                    id - k == BOX_IDS ? &box_names :
+                    id - k == CYLINDER_IDS ? &cylinder_names :
+                    id - k == PLANE_IDS ? &plane_names : nullptr;
+
+                return ids && k < ids->size() ? names.get((*ids)[k]) : "";
+            }
 
             pose_t getRobotPose()
             {
@@ -103,9 +1048,15 @@ namespace simsens {
 
             void dump()
             {
-                for (auto wall : walls) {
-                    wall->dump();
+                for (const auto & wall : walls) {
+                    if (wall.size.z > -INFINITY) {
+                        wall.dump();
+                    }
                 }
+
+                boxes.dump();
+                cylinders.dump();
+                planes.dump();
             }
 
     };